@@ -2,12 +2,40 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <iomanip>
 #include <limits>
 #include <stdexcept>
 #include <algorithm>
 #include <map>
+#include <queue>
+#include <list>
 #include <set>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <numeric>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <thread>
+#include <fstream>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <malloc.h>
 
 using namespace std;
 
@@ -19,6 +47,7 @@ class Patient;
 class Appointment;
 class Inventory;
 class Record;
+class AppointmentBook;
 
 class InvalidInputException : public runtime_error {
 public:
@@ -45,42 +74,198 @@ void displayDetails(const T& obj) {
     obj.display();
 }
 
+// Parsing without exceptions, for bulk and automated input: every parser
+// returns the value together with an error code, and never allocates.
+enum class ParseError { None, Empty, Invalid, OutOfRange, Trailing };
+
+template <typename T>
+struct Parsed {
+    T value;
+    ParseError error;
+
+    bool ok() const {
+        return error == ParseError::None;
+    }
+};
+
+const char* parseErrorName(ParseError error) {
+    switch (error) {
+        case ParseError::None: return "ok";
+        case ParseError::Empty: return "empty";
+        case ParseError::Invalid: return "invalid";
+        case ParseError::OutOfRange: return "out of range";
+        case ParseError::Trailing: return "trailing characters";
+    }
+    return "unknown";
+}
+
+// Whole-field int or double; like operator>>, a leading '+' is accepted.
+// from_chars also reads "nan" and "inf", which are rejected: no field here
+// can hold them.
+template <typename T>
+Parsed<T> parseNumber(string_view text) {
+    T value{};
+    if (text.empty()) return { value, ParseError::Empty };
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (*first == '+' && last - first > 1 && first[1] != '-') ++first;
+    auto result = from_chars(first, last, value);
+    if (result.ec == errc::invalid_argument) return { value, ParseError::Invalid };
+    if (result.ec == errc::result_out_of_range) return { value, ParseError::OutOfRange };
+    if (result.ptr != last) return { value, ParseError::Trailing };
+    if constexpr (is_floating_point_v<T>) {
+        if (!isfinite(value)) return { value, ParseError::Invalid };
+    }
+    return { value, ParseError::None };
+}
+
+Parsed<bool> parseYesNo(string_view text) {
+    if (text.empty()) return { false, ParseError::Empty };
+    if (text == "y") return { true, ParseError::None };
+    if (text == "n") return { false, ParseError::None };
+    return { false, ParseError::Invalid };
+}
+
+// The interactive prompts below read one whitespace-delimited token and
+// parse it with the functions above. Exceptions are kept for this
+// boundary only; a rejected token discards the rest of the line.
+string readInputToken() {
+    string token;
+    cin >> token;
+    return token;
+}
+
+void discardInputLine() {
+    cin.clear();
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
 int getValidIntegerInput(const string& prompt) {
-    int value;
     cout << prompt;
-    cin >> value;
-    if (cin.fail()) {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    Parsed<int> parsed = parseNumber<int>(readInputToken());
+    if (!parsed.ok()) {
+        discardInputLine();
         throw InvalidInputException("Invalid integer input. Please try again.");
     }
-    return value;
+    return parsed.value;
 }
 
 double getValidDoubleInput(const string& prompt) {
-    double value;
     cout << prompt;
-    cin >> value;
-    if (cin.fail()) {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    Parsed<double> parsed = parseNumber<double>(readInputToken());
+    if (!parsed.ok()) {
+        discardInputLine();
         throw InvalidInputException("Invalid floating-point input. Please try again.");
     }
-    return value;
+    return parsed.value;
 }
 
 bool getYesNoInput(const string& prompt) {
-    char response;
     cout << prompt << " (y/n): ";
-    cin >> response;
-    if (cin.fail() || (response != 'y' && response != 'n')) {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    Parsed<bool> parsed = parseYesNo(readInputToken());
+    if (!parsed.ok()) {
+        discardInputLine();
         throw InvalidInputException("Invalid input. Please enter 'y' or 'n'.");
     }
-    return response == 'y';
+    return parsed.value;
+}
+
+bool isValidPhoneNumber(const string& phone) {
+    if (phone.length() != 10) return false;
+    for (char c : phone) {
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+uint64_t packPhoneNumber(const string& phone) {
+    if (!isValidPhoneNumber(phone)) {
+        throw InvalidInputException("Invalid phone number. Must be exactly 10 digits.");
+    }
+    uint64_t packed = 0;
+    for (char c : phone) {
+        packed = packed * 10 + (c - '0');
+    }
+    return packed;
+}
+
+string formatPhoneNumber(uint64_t phone) {
+    string digits(10, '0');
+    for (int i = 9; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + phone % 10);
+        phone /= 10;
+    }
+    return digits;
 }
 
+// Caller-ID index: open addressing over single 64-bit slots, each packing a
+// 34-bit phone number above a 30-bit patient handle (index into patients).
+class PhoneIndex {
+private:
+    static constexpr int handleBits = 30;
+    static constexpr uint64_t handleMask = (uint64_t(1) << handleBits) - 1;
+    static constexpr uint64_t emptySlot = ~uint64_t(0);
+
+    vector<uint64_t> slots;
+    size_t count;
+    int shift;
+
+    size_t home(uint64_t phone) const {
+        return static_cast<size_t>((phone * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    void place(uint64_t slot) {
+        size_t mask = slots.size() - 1;
+        size_t i = home(slot >> handleBits);
+        while (slots[i] != emptySlot) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+
+    void grow() {
+        vector<uint64_t> old(slots.size() * 2, emptySlot);
+        old.swap(slots);
+        --shift;
+        for (uint64_t slot : old) {
+            if (slot != emptySlot) place(slot);
+        }
+    }
+
+public:
+    PhoneIndex() : slots(16, emptySlot), count(0), shift(64 - 4) {}
+
+    // Returns false if the phone number is already registered.
+    bool insert(uint64_t phone, size_t handle) {
+        if (handle > handleMask) {
+            throw runtime_error("Phone index handle out of range.");
+        }
+        size_t existing;
+        if (find(phone, existing)) return false;
+        if ((count + 1) * 4 > slots.size() * 3) grow();
+        place((phone << handleBits) | handle);
+        ++count;
+        return true;
+    }
+
+    bool find(uint64_t phone, size_t& handle) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = home(phone); slots[i] != emptySlot; i = (i + 1) & mask) {
+            if ((slots[i] >> handleBits) == phone) {
+                handle = static_cast<size_t>(slots[i] & handleMask);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t memoryBytes() const {
+        return slots.capacity() * sizeof(uint64_t);
+    }
+};
+
 class Appointment {
 private:
     string patientName;
@@ -108,392 +293,5908 @@ public:
     const string& getDoctorName() const {
         return doctorName;
     }
-};
-
-class Patient {
-private:
-    string name;
-    int previousAdmittances;
-    double paymentDue;
-    bool hasAppointment;
-    string appointmentDate;
-    string phoneNumber;
 
-public:
-    Patient(const string& n, int prevAdmit, double payment, bool appointment, const string& date, const string& phone)
-        : name(n), previousAdmittances(prevAdmit), paymentDue(payment), hasAppointment(appointment), appointmentDate(date), phoneNumber(phone) {}
+    void reschedule(const string& dateTime) {
+        dateAndTime = dateTime;
+    }
+};
 
-    void display() const {
-        cout << "Name: " << name << endl;
-        cout << "Previous Admittances: " << previousAdmittances << endl;
-        cout << "Payment Due: " << paymentDue << endl;
-        cout << "Appointment Scheduled: " << (hasAppointment ? "Yes" : "No") << endl;
-        if (hasAppointment) {
-            cout << "Appointment Date: " << appointmentDate << endl;
+bool isValidDateTime(string_view dateTime) {
+    // YYYY-MM-DD HH:MM, so that string order is chronological order
+    static constexpr string_view pattern = "dddd-dd-dd dd:dd";
+    if (dateTime.size() != pattern.size()) return false;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == 'd' ? !isdigit(static_cast<unsigned char>(dateTime[i])) : dateTime[i] != pattern[i]) {
+            return false;
         }
-        cout << "Phone Number: " << phoneNumber << endl;
     }
+    return true;
+}
 
-    bool matchesName(const string& searchName) const {
-        return name == searchName;
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+long daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<long>(dayOfEra) - 719468;
+}
+
+void civilFromDays(long days, int& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const long era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    year = static_cast<int>(yearOfEra + era * 400) + (month <= 2);
+}
+
+const long packedEpochDays = daysFromCivil(2000, 1, 1);
+
+// Packs YYYY-MM-DD HH:MM into minutes since 2000-01-01 00:00
+Parsed<uint32_t> parseDateTime(string_view dateTime) {
+    if (dateTime.empty()) return { 0, ParseError::Empty };
+    if (!isValidDateTime(dateTime)) return { 0, ParseError::Invalid };
+    auto digits = [&](size_t first, size_t count) {
+        unsigned value = 0;
+        for (size_t i = first; i < first + count; ++i) value = value * 10 + (dateTime[i] - '0');
+        return value;
+    };
+    int year = static_cast<int>(digits(0, 4));
+    unsigned month = digits(5, 2);
+    unsigned day = digits(8, 2);
+    unsigned hour = digits(11, 2);
+    unsigned minute = digits(14, 2);
+
+    static const unsigned daysInMonth[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    if (year < 2000 || month < 1 || month > 12 || day < 1 || day > daysInMonth[month - 1]
+        || (month == 2 && day == 29 && !leap) || hour > 23 || minute > 59) {
+        return { 0, ParseError::OutOfRange };
     }
+    long days = daysFromCivil(year, month, day) - packedEpochDays;
+    return { static_cast<uint32_t>(days * 1440 + hour * 60 + minute), ParseError::None };
+}
 
-    void displayDues() const {
-        cout << "Payment Due: " << paymentDue << endl;
+uint32_t packDateTime(const string& dateTime) {
+    Parsed<uint32_t> parsed = parseDateTime(dateTime);
+    if (!parsed.ok()) {
+        throw InvalidInputException("Invalid date and time. Use YYYY-MM-DD HH:MM.");
     }
+    return parsed.value;
+}
 
-    void displayAppointments() const {
-        cout << "Appointment Scheduled: " << (hasAppointment ? "Yes" : "No") << endl;
-        if (hasAppointment) {
-            cout << "Appointment Date: " << appointmentDate << endl;
+void formatDateTime(uint32_t minutes, char (&buffer)[17]) {
+    int year;
+    unsigned month, day;
+    civilFromDays(packedEpochDays + minutes / 1440, year, month, day);
+    snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u %02u:%02u", year, month, day, (minutes % 1440) / 60, minutes % 60);
+}
+
+string formatDateTime(uint32_t minutes) {
+    char buffer[17];
+    formatDateTime(minutes, buffer);
+    return buffer;
+}
+
+// Minutes since 2000-01-01 00:00 UTC, straight from the epoch clock. Unlike
+// local wall time it never repeats an hour when the clocks fall back, so the
+// version chains, consumption buckets and expiry times stay in order.
+uint32_t currentMinutes() {
+    return static_cast<uint32_t>((time(nullptr) - packedEpochDays * 86400L) / 60);
+}
+
+// Delta chain of (time, value) versions for point-in-time queries. Only
+// changes are stored, and asOf() is a binary search over them.
+template <typename T>
+class VersionChain {
+private:
+    vector<pair<uint32_t, T>> versions;
+
+public:
+    // Changes within the same minute collapse into one version
+    void record(uint32_t minutes, const T& value) {
+        if (!versions.empty() && minutes <= versions.back().first) {
+            versions.back().second = value;
+        } else {
+            versions.emplace_back(minutes, value);
         }
     }
 
-    const string& getName() const {
-        return name;
+    // The value in effect at the given minute, or nullptr if there was none yet
+    const T* asOf(uint32_t minutes) const {
+        auto it = upper_bound(versions.begin(), versions.end(), minutes,
+                              [](uint32_t m, const pair<uint32_t, T>& version){ return m < version.first; });
+        return it == versions.begin() ? nullptr : &prev(it)->second;
+    }
+
+    size_t size() const {
+        return versions.size();
     }
 };
 
-class Inventory {
+string todaysDate() {
+    time_t now = time(nullptr);
+    char buffer[11];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d", localtime(&now));
+    return buffer;
+}
+
+// Mirror mutations into an attached shared segment; defined after SharedTables.
+// Each writes only the field the caller changed, so concurrent desks do not
+// overwrite each other's updates.
+void sharePatient(const Patient& patient);
+void unsharePatient(const string& name);
+void sharePaymentDue(const Patient& patient);
+void shareAppointmentDate(const Patient& patient);
+void shareAppointment(const Appointment& appointment);
+void unshareAppointment(const Appointment& appointment);
+
+// Report a new appointment to a running event log; defined after MutationLog
+void logAppointmentAdded(const string& patient, const string& dateTime, const string& doctor);
+
+// Write a new patient through to an open disk registry; defined after PatientStore
+void storePatient(const Patient& patient);
+
+// While a segment is attached it holds the stock: these change or read it
+// there and return false when none is attached
+bool sharedStockAdd(const string& itemName, int quantity, int64_t& level);
+bool sharedStockRemove(const string& itemName, int quantity, int64_t& level);
+bool sharedStockLevel(const string& itemName, int64_t& level);
+bool sharedStockLevels(vector<pair<string, int64_t>>& levels);
+
+struct RescheduleNotice {
+    string patientName;
+    string oldDateTime;
+    string newDateTime; // empty when the appointment was cancelled
+};
+
+class AppointmentBook {
 private:
-    map<string, int> items;
+    typedef multimap<string, Appointment*> TimeIndex;
 
-public:
-    Inventory() {
-        items["B+ Blood bags"] = 12;
-        items["A+ Blood bags"] = 0;
-        items["O+ Blood bags"] = 40;
-        items["Syringes"] = 3300;
-        items["Crocin"] = 4500;
-        items["Hydrochloroquine"] = 100;
+    // Where an appointment sits in each index, so removal never scans a
+    // run of equal times. Multimap iterators survive other inserts and erases.
+    struct IndexLinks {
+        TimeIndex::iterator doctor;
+        TimeIndex::iterator patient;
+        TimeIndex::iterator time;
+    };
+
+    vector<unique_ptr<Appointment>> appointments;
+    map<string, TimeIndex> byDoctor;
+    map<string, TimeIndex> byPatient;
+    TimeIndex byTime;
+    unordered_map<const Appointment*, IndexLinks> links;
+
+    void unlinkPatient(const Appointment* appointment, const IndexLinks& link) {
+        auto patientIt = byPatient.find(appointment->getPatientName());
+        patientIt->second.erase(link.patient);
+        if (patientIt->second.empty()) byPatient.erase(patientIt);
     }
 
-    void addItem(const string& itemName, int quantity) {
-        items[itemName] += quantity;
+    void unlinkDoctor(const Appointment* appointment, const IndexLinks& link) {
+        auto doctorIt = byDoctor.find(appointment->getDoctorName());
+        doctorIt->second.erase(link.doctor);
+        if (doctorIt->second.empty()) byDoctor.erase(doctorIt);
     }
 
-    void removeItem(const string& itemName, int quantity) {
-        if (items.count(itemName) && items[itemName] >= quantity) {
-            items[itemName] -= quantity;
-        } else {
-            throw InsufficientInventoryException("Insufficient quantity of " + itemName + " in inventory.");
-        }
+    // A bare date as the upper bound covers the whole day
+    static string upperKey(const string& to) {
+        return to.size() == 10 ? to + " 23:59" : to;
     }
 
-    void display() const {
-        cout << "Inventory Records:" << endl;
-        for (const auto& pair : items) {
-            cout << pair.first << ": " << pair.second << " in quantity" << endl;
+    static void displayRange(TimeIndex::const_iterator first, TimeIndex::const_iterator last) {
+        if (first == last) {
+            cout << "No appointments found." << endl;
+            return;
+        }
+        for (; first != last; ++first) {
+            displayDetails(*first->second);
+            cout << "------------------------------" << endl;
         }
     }
-};
-
-class Staff {
-protected:
-    string name;
-    double salary;
 
 public:
-    Staff(const string& n, double s) : name(n), salary(s) {}
-    virtual void displayEarnings() const = 0;
-    virtual void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const = 0;
-    virtual void displayInventory(const Inventory& inventory) const = 0;
-    virtual void manageAppointments(const vector<unique_ptr<Appointment>>& appointments, const vector<unique_ptr<Patient>>& patients, const vector<unique_ptr<Doctor>>& doctors) const {} // Default implementation for those who don't manage appointments
-    virtual void manageInventorySystem(Inventory& inventory) const {} // Default implementation
-    virtual ~Staff() {}
-
-    const string& getName() const {
-        return name;
+    void add(const string& patient, const string& dateTime, const string& doctor) {
+        appointments.push_back(make_unique<Appointment>(patient, dateTime, doctor));
+        Appointment* appointment = appointments.back().get();
+        links.emplace(appointment, IndexLinks{ byDoctor[doctor].emplace(dateTime, appointment),
+                                               byPatient[patient].emplace(dateTime, appointment),
+                                               byTime.emplace(dateTime, appointment) });
+        shareAppointment(*appointment);
+        logAppointmentAdded(patient, dateTime, doctor);
     }
-};
 
-class Doctor : public Staff {
-public:
-    Doctor(const string& n) : Staff(n, 150000.0) {}
+    bool cancel(const string& patient, const string& dateTime) {
+        auto patientIt = byPatient.find(patient);
+        if (patientIt == byPatient.end()) return false;
+        auto slot = patientIt->second.find(dateTime);
+        if (slot == patientIt->second.end()) return false;
 
-    void displayEarnings() const override {
-        cout << "Doctor " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+        Appointment* appointment = slot->second;
+        unshareAppointment(*appointment);
+        auto linkIt = links.find(appointment);
+        unlinkPatient(appointment, linkIt->second);
+        unlinkDoctor(appointment, linkIt->second);
+        byTime.erase(linkIt->second.time);
+        links.erase(linkIt);
+        appointments.erase(find_if(appointments.begin(), appointments.end(),
+                                   [&](const unique_ptr<Appointment>& a){ return a.get() == appointment; }));
+        return true;
     }
 
-    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
-        cout << "Doctor " << name << ", here are the patient details:" << endl;
-        for (const auto& patient : patients) {
-            displayDetails(*patient);
-            cout << endl;
+    // Cancels every appointment a doctor has between from and to, in one walk
+    // of the doctor's time index and one compaction of the appointment list.
+    vector<RescheduleNotice> cancelForDoctor(const string& doctor, const string& from, const string& to) {
+        vector<RescheduleNotice> notices;
+        auto doctorIt = byDoctor.find(doctor);
+        if (doctorIt == byDoctor.end()) return notices;
+
+        TimeIndex& slots = doctorIt->second;
+        auto first = slots.lower_bound(from);
+        auto last = slots.upper_bound(upperKey(to));
+        unordered_set<const Appointment*> cancelled;
+        for (auto it = first; it != last; ++it) {
+            const Appointment* appointment = it->second;
+            notices.push_back({ appointment->getPatientName(), appointment->getDateAndTime(), "" });
+            cancelled.insert(appointment);
+            unshareAppointment(*appointment);
+            auto linkIt = links.find(appointment);
+            unlinkPatient(appointment, linkIt->second);
+            byTime.erase(linkIt->second.time);
+            links.erase(linkIt);
         }
-    }
+        slots.erase(first, last);
+        if (slots.empty()) byDoctor.erase(doctorIt);
 
-    void displayInventory(const Inventory& inventory) const override {
-        inventory.display();
+        appointments.erase(remove_if(appointments.begin(), appointments.end(),
+                                     [&](const unique_ptr<Appointment>& a){ return cancelled.count(a.get()) > 0; }),
+                           appointments.end());
+        return notices;
     }
-};
 
-class Nurse : public Staff {
-public:
-    Nurse(const string& n) : Staff(n, 75000.0) {}
+    // Moves every appointment a doctor has between from and to by shiftMinutes.
+    // All new times are checked before anything changes.
+    vector<RescheduleNotice> shiftForDoctor(const string& doctor, const string& from, const string& to, long shiftMinutes) {
+        vector<RescheduleNotice> notices;
+        auto doctorIt = byDoctor.find(doctor);
+        if (doctorIt == byDoctor.end()) return notices;
 
-    void displayEarnings() const override {
-        cout << "Nurse " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+        TimeIndex& slots = doctorIt->second;
+        auto first = slots.lower_bound(from);
+        auto last = slots.upper_bound(upperKey(to));
+        vector<pair<Appointment*, string>> moves;
+        for (auto it = first; it != last; ++it) {
+            long moved = static_cast<long>(packDateTime(it->second->getDateAndTime())) + shiftMinutes;
+            if (moved < 0 || moved > static_cast<long>(numeric_limits<uint32_t>::max())) {
+                throw InvalidInputException("Shifted appointment date is out of range.");
+            }
+            moves.emplace_back(it->second, formatDateTime(static_cast<uint32_t>(moved)));
+        }
+        // Appointments in the range all move together, so only one left in
+        // place can already hold a new slot
+        string lastKey = upperKey(to);
+        for (const auto& pending : moves) {
+            auto clash = slots.find(pending.second);
+            if (clash != slots.end() && (clash->first < from || clash->first > lastKey)) {
+                throw InvalidInputException(doctor + " already has an appointment at " + pending.second + "; nothing was moved.");
+            }
+        }
+        slots.erase(first, last);
+
+        for (auto& pending : moves) {
+            Appointment* appointment = pending.first;
+            notices.push_back({ appointment->getPatientName(), appointment->getDateAndTime(), pending.second });
+            TimeIndex& patientSlots = byPatient[appointment->getPatientName()];
+            IndexLinks& link = links[appointment];
+            patientSlots.erase(link.patient);
+            byTime.erase(link.time);
+
+            unshareAppointment(*appointment);
+            appointment->reschedule(pending.second);
+            shareAppointment(*appointment);
+            link.doctor = slots.emplace(pending.second, appointment);
+            link.patient = patientSlots.emplace(pending.second, appointment);
+            link.time = byTime.emplace(pending.second, appointment);
+        }
+        return notices;
     }
 
-    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
-        cout << "Nurse " << name << ", here are the patient details:" << endl;
-        for (const auto& patient : patients) {
-            displayDetails(*patient);
-            cout << endl;
+    // Appointments before cutoff, oldest first; nothing is removed
+    vector<const Appointment*> before(const string& cutoff) const {
+        vector<const Appointment*> found;
+        for (auto it = byTime.begin(), last = byTime.lower_bound(cutoff); it != last; ++it) {
+            found.push_back(it->second);
         }
+        return found;
     }
 
-    void displayInventory(const Inventory& inventory) const override {
-        inventory.display();
+    // Removes the given appointments in one compaction of the appointment list
+    void remove(const unordered_set<const Appointment*>& removed) {
+        for (const Appointment* appointment : removed) {
+            unshareAppointment(*appointment);
+            auto linkIt = links.find(appointment);
+            unlinkPatient(appointment, linkIt->second);
+            unlinkDoctor(appointment, linkIt->second);
+            byTime.erase(linkIt->second.time);
+            links.erase(linkIt);
+        }
+        appointments.erase(remove_if(appointments.begin(), appointments.end(),
+                                     [&](const unique_ptr<Appointment>& a){ return removed.count(a.get()) > 0; }),
+                           appointments.end());
     }
-};
 
-class Receptionist : public Staff {
-public:
-    Receptionist(const string& n) : Staff(n, 60000.0) {}
+    const vector<unique_ptr<Appointment>>& all() const {
+        return appointments;
+    }
 
-    void displayEarnings() const override {
-        cout << "Receptionist " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    // The patient's first appointment at or after the given time, if any
+    const Appointment* nextFor(const string& patient, const string& from) const {
+        auto it = byPatient.find(patient);
+        if (it == byPatient.end()) return nullptr;
+        auto slot = it->second.lower_bound(from);
+        return slot == it->second.end() ? nullptr : slot->second;
     }
 
-    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
-        cout << "Receptionist " << name << ", here are the patient details:" << endl;
-        for (const auto& patient : patients) {
-            displayDetails(*patient);
-            cout << endl;
+    void displayForDoctor(const string& doctor, const string& from, const string& to) const {
+        auto it = byDoctor.find(doctor);
+        if (it == byDoctor.end()) {
+            cout << "No appointments found." << endl;
+            return;
         }
+        displayRange(it->second.lower_bound(from), it->second.upper_bound(upperKey(to)));
     }
 
-    void displayInventory(const Inventory& inventory) const override {
-        cout << "Receptionists do not typically view inventory." << endl;
+    void displayForPatient(const string& patient) const {
+        auto it = byPatient.find(patient);
+        if (it == byPatient.end()) {
+            cout << "No appointments found." << endl;
+            return;
+        }
+        displayRange(it->second.begin(), it->second.end());
     }
 
-    void manageAppointments(const vector<unique_ptr<Appointment>>& appointments, const vector<unique_ptr<Patient>>& patients, const vector<unique_ptr<Doctor>>& doctors) const override {
-        cout << "--- Appointment Management ---" << endl;
-        int choice;
-        do {
-            cout << "\n1. Add New Appointment" << endl;
-            cout << "2. Display All Appointments" << endl;
-            cout << "0. Back to Main Menu" << endl;
-            cout << "Enter your choice: ";
-            try {
-                choice = getValidIntegerInput("");
-                switch (choice) {
-                    case 1: {
-                        string patientName, doctorName, dateTime;
-
-                        cout << "Enter patient name for the appointment: ";
-                        cin >> patientName;
+    void displayBetween(const string& from, const string& to) const {
+        displayRange(byTime.lower_bound(from), byTime.upper_bound(upperKey(to)));
+    }
+};
 
-                        auto patientIt = find_if(patients.begin(), patients.end(),
-                                             [&](const unique_ptr<Patient>& p){ return p->getName() == patientName; });
-                        if (patientIt == patients.end()) {
-                            throw PatientNotFoundException("Patient not found!");
-                        }
+// Fixed 24-byte string: up to 23 characters inline, longer ones spill to the heap.
+class CompactString {
+private:
+    static constexpr size_t inlineCapacity = 23;
+    static constexpr unsigned char heapTag = 0xFF;
+    char bytes[inlineCapacity + 1];
 
-                        cout << "Enter doctor's name for the appointment: ";
-                        cin >> doctorName;
-                        // Ideally, you'd validate if the doctor exists here
+    bool onHeap() const {
+        return static_cast<unsigned char>(bytes[inlineCapacity]) == heapTag;
+    }
 
-                        cout << "Enter appointment date and time (e.g.,YYYY-MM-DD HH:MM): ";
-                        cin.ignore();
-                        getline(cin, dateTime);
+    void assign(const char* text, size_t length) {
+        if (length <= inlineCapacity) {
+            memcpy(bytes, text, length);
+            bytes[inlineCapacity] = static_cast<char>(length);
+        } else {
+            char* spilled = new char[length];
+            memcpy(spilled, text, length);
+            memcpy(bytes, &spilled, sizeof(spilled));
+            memcpy(bytes + sizeof(spilled), &length, sizeof(length));
+            bytes[inlineCapacity] = static_cast<char>(heapTag);
+        }
+    }
 
-                        // In a real system, you'd have a way to add this new appointment
-                        cout << "New appointment scheduled for " << patientName << " with " << doctorName << " on " << dateTime << endl;
-                        // appointments.push_back(make_unique<Appointment>(patientName, dateTime, doctorName));
-                        break;
-                    }
-                    case 2: {
-                        cout << "--- All Scheduled Appointments ---" << endl;
-                        if (appointments.empty()) {
-                            cout << "No appointments scheduled." << endl;
-                        } else {
-                            for (const auto& appointment : appointments) {
-                                displayDetails(*appointment);
-                                cout << "------------------------------" << endl;
-                            }
-                        }
-                        break;
-                    }
-                    case 0:
-                        cout << "Returning to main menu." << endl;
-                        break;
-                    default:
-                        cout << "Invalid choice!" << endl;
-                }
-            } catch (const InvalidInputException& e) {
-                cerr << "Error: " << e.what() << endl;
-            } catch (const PatientNotFoundException& e) {
-                cerr << "Error: " << e.what() << endl;
-            }
-        } while (choice != 0);
+    void release() {
+        if (onHeap()) delete[] data();
     }
-};
 
-class Administrator : public Staff {
 public:
-    Administrator(const string& n) : Staff(n, 90000.0) {}
+    CompactString(const string& text) {
+        assign(text.data(), text.size());
+    }
 
-    void displayEarnings() const override {
-        cout << "Administrator " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    CompactString(const CompactString& other) {
+        assign(other.data(), other.size());
     }
 
-    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
-        cout << "Administrator " << name << ", here are the patient details:" << endl;
-        for (const auto& patient : patients) {
-            displayDetails(*patient);
-            cout << endl;
+    CompactString& operator=(const CompactString& other) {
+        if (this != &other) {
+            release();
+            assign(other.data(), other.size());
         }
+        return *this;
     }
 
-    void displayInventory(const Inventory& inventory) const override {
-        inventory.display();
+    ~CompactString() {
+        release();
     }
 
-    void manageInventorySystem(Inventory& inventory) const override {
-        manageInventorySystem(inventory); // Reusing the existing inventory management function
+    const char* data() const {
+        if (!onHeap()) return bytes;
+        char* spilled;
+        memcpy(&spilled, bytes, sizeof(spilled));
+        return spilled;
+    }
+
+    size_t size() const {
+        if (!onHeap()) return static_cast<unsigned char>(bytes[inlineCapacity]);
+        size_t length;
+        memcpy(&length, bytes + sizeof(char*), sizeof(length));
+        return length;
+    }
+
+    bool equals(const string& text) const {
+        return text.size() == size() && memcmp(text.data(), data(), text.size()) == 0;
+    }
+
+    string str() const {
+        return string(data(), size());
+    }
+
+    size_t heapBytes() const {
+        return onHeap() ? size() : 0;
+    }
+};
+
+// Stamps every version of a patient record; a record gets a new stamp
+// whenever it changes, so a stamp names one rendering of a patient.
+uint32_t nextPatientRevision() {
+    static uint32_t next = 0;
+    return ++next;
+}
+
+class Patient {
+private:
+    // Packed into 48 bytes: see displayMemoryReport().
+    // contact holds the phone number (bits 0-33), previous admittances
+    // (bits 34-62) and the has-appointment flag (bit 63).
+    static constexpr int admittanceShift = 34;
+    static constexpr uint64_t phoneMask = (uint64_t(1) << admittanceShift) - 1;
+    static constexpr uint64_t maxAdmittances = (uint64_t(1) << 29) - 1;
+    static constexpr uint64_t appointmentFlag = uint64_t(1) << 63;
+
+    CompactString name;
+    double paymentDue;
+    uint64_t contact;
+    uint32_t appointmentMinutes;
+    uint32_t revision;
+
+public:
+    // Dues are kept to a range whose cents fit comfortably in 64 bits
+    static constexpr double maxPaymentDue = 1e12;
+
+    static void checkPaymentDue(double payment) {
+        if (!(payment >= 0 && payment <= maxPaymentDue)) {
+            throw InvalidInputException("Payment due must be between 0 and 1000000000000.");
+        }
+    }
+
+    Patient(const string& n, int prevAdmit, double payment, bool appointment, const string& date, const string& phone)
+        : name(n), paymentDue(payment), contact(packPhoneNumber(phone)), appointmentMinutes(0),
+          revision(nextPatientRevision()) {
+        checkPaymentDue(payment);
+        if (prevAdmit < 0 || static_cast<uint64_t>(prevAdmit) > maxAdmittances) {
+            throw InvalidInputException("Invalid number of previous admittances.");
+        }
+        contact |= static_cast<uint64_t>(prevAdmit) << admittanceShift;
+        if (appointment) {
+            appointmentMinutes = packDateTime(date);
+            contact |= appointmentFlag;
+        }
+    }
+
+    void display(ostream& out = cout) const {
+        out << "Name: " << name.str() << endl;
+        out << "Previous Admittances: " << getPreviousAdmittances() << endl;
+        out << "Payment Due: " << paymentDue << endl;
+        out << "Appointment Scheduled: " << (hasAppointment() ? "Yes" : "No") << endl;
+        if (hasAppointment()) {
+            out << "Appointment Date: " << formatDateTime(appointmentMinutes) << endl;
+        }
+        out << "Phone Number: " << formatPhoneNumber(getPhoneNumber()) << endl;
+    }
+
+    bool matchesName(const string& searchName) const {
+        return name.equals(searchName);
+    }
+
+    void displayDues() const {
+        cout << "Payment Due: " << paymentDue << endl;
+    }
+
+    void displayAppointments() const {
+        cout << "Appointment Scheduled: " << (hasAppointment() ? "Yes" : "No") << endl;
+        if (hasAppointment()) {
+            cout << "Appointment Date: " << formatDateTime(appointmentMinutes) << endl;
+        }
+    }
+
+    string getName() const {
+        return name.str();
+    }
+
+    const CompactString& getCompactName() const {
+        return name;
+    }
+
+    double getPaymentDue() const {
+        return paymentDue;
+    }
+
+    uint32_t getAppointmentMinutes() const {
+        return appointmentMinutes;
+    }
+
+    int getPreviousAdmittances() const {
+        return static_cast<int>((contact & ~appointmentFlag) >> admittanceShift);
+    }
+
+    bool hasAppointment() const {
+        return (contact & appointmentFlag) != 0;
+    }
+
+    uint64_t getPhoneNumber() const {
+        return contact & phoneMask;
+    }
+
+    uint32_t getRevision() const {
+        return revision;
+    }
+
+    void setPaymentDue(double payment) {
+        checkPaymentDue(payment);
+        paymentDue = payment;
+        revision = nextPatientRevision();
+    }
+
+    void setAppointment(bool appointment, uint32_t minutes) {
+        contact = appointment ? contact | appointmentFlag : contact & ~appointmentFlag;
+        appointmentMinutes = appointment ? minutes : 0;
+        revision = nextPatientRevision();
+    }
+
+    size_t heapBytes() const {
+        return name.heapBytes();
+    }
+};
+
+struct PatientSnapshot {
+    double paymentDue;
+    int previousAdmittances;
+    bool hasAppointment;
+    uint32_t appointmentMinutes;
+};
+
+// Version chains of patient records, indexed by patient handle
+class PatientHistory {
+private:
+    vector<VersionChain<PatientSnapshot>> chains;
+
+public:
+    void record(size_t handle, const Patient& patient) {
+        if (handle >= chains.size()) chains.resize(handle + 1);
+        chains[handle].record(currentMinutes(), { patient.getPaymentDue(), patient.getPreviousAdmittances(),
+                                                  patient.hasAppointment(), patient.getAppointmentMinutes() });
+    }
+
+    const PatientSnapshot* asOf(size_t handle, uint32_t minutes) const {
+        return handle < chains.size() ? chains[handle].asOf(minutes) : nullptr;
+    }
+
+    // Drops the chains of removed handles, keeping the rest in handle order
+    void compact(const vector<bool>& removed) {
+        size_t kept = 0;
+        for (size_t handle = 0; handle < chains.size(); ++handle) {
+            if (handle < removed.size() && removed[handle]) continue;
+            if (kept != handle) chains[kept] = move(chains[handle]);
+            ++kept;
+        }
+        chains.resize(kept);
+    }
+};
+
+static_assert(sizeof(Patient) <= 64, "Patient hot data must fit in one cache line");
+
+// Rendered display() text of recently shown patients, keyed by record
+// revision, so a changed record simply misses and is rendered afresh. The
+// least recently shown views are evicted once the cache exceeds its budget.
+class PatientViewCache {
+private:
+    // Rough cost of the list and map nodes behind each cached view
+    static constexpr size_t entryOverhead = 96;
+
+    list<pair<uint32_t, string>> recent;   // most recently shown first
+    unordered_map<uint32_t, list<pair<uint32_t, string>>::iterator> cached;
+    size_t budget;
+    size_t used;
+    string uncached;   // a view too large for the whole budget
+
+    void evictOverBudget() {
+        while (used > budget && !recent.empty()) {
+            used -= recent.back().second.size() + entryOverhead;
+            cached.erase(recent.back().first);
+            recent.pop_back();
+            ++evictions;
+        }
+    }
+
+public:
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    PatientViewCache(size_t budgetBytes) : budget(budgetBytes), used(0) {}
+
+    const string& render(const Patient& patient) {
+        auto found = cached.find(patient.getRevision());
+        if (found != cached.end()) {
+            ++hits;
+            recent.splice(recent.begin(), recent, found->second);
+            return found->second->second;
+        }
+        ++misses;
+        ostringstream text;
+        patient.display(text);
+        string view = text.str();
+        size_t cost = view.size() + entryOverhead;
+        if (cost > budget) {
+            uncached = move(view);
+            return uncached;
+        }
+        recent.emplace_front(patient.getRevision(), move(view));
+        cached[patient.getRevision()] = recent.begin();
+        used += cost;
+        evictOverBudget();
+        return recent.front().second;
+    }
+
+    void display(const Patient& patient, ostream& out = cout) {
+        const string& text = render(patient);
+        out.write(text.data(), text.size());
+    }
+
+    // Drops the view of a revision that is about to be replaced
+    void forget(uint32_t revision) {
+        auto found = cached.find(revision);
+        if (found == cached.end()) return;
+        used -= found->second->second.size() + entryOverhead;
+        recent.erase(found->second);
+        cached.erase(found);
+    }
+
+    void resize(size_t budgetBytes) {
+        budget = budgetBytes;
+        evictOverBudget();
+    }
+
+    size_t entries() const {
+        return recent.size();
+    }
+
+    size_t bytes() const {
+        return used;
+    }
+
+    size_t capacity() const {
+        return budget;
+    }
+};
+
+PatientViewCache patientViews(256 * 1024);
+
+void registerPatient(vector<unique_ptr<Patient>>& patients, PhoneIndex& phoneIndex, PatientHistory& history, unique_ptr<Patient> patient) {
+    if (!phoneIndex.insert(patient->getPhoneNumber(), patients.size())) {
+        throw InvalidInputException("Phone number " + formatPhoneNumber(patient->getPhoneNumber()) + " is already registered.");
+    }
+    history.record(patients.size(), *patient);
+    sharePatient(*patient);
+    storePatient(*patient);
+    patients.push_back(move(patient));
+}
+
+// Removes the flagged patients. Handles are positions in the patient list, so
+// the phone index is rebuilt and the history renumbered to match.
+void unregisterPatients(vector<unique_ptr<Patient>>& patients, PhoneIndex& phoneIndex, PatientHistory& history, const vector<bool>& removed) {
+    size_t kept = 0;
+    for (size_t handle = 0; handle < patients.size(); ++handle) {
+        if (removed[handle]) {
+            unsharePatient(patients[handle]->getName());
+            continue;
+        }
+        if (kept != handle) patients[kept] = move(patients[handle]);
+        ++kept;
+    }
+    patients.resize(kept);
+    history.compact(removed);
+    phoneIndex = PhoneIndex();
+    for (size_t handle = 0; handle < patients.size(); ++handle) {
+        phoneIndex.insert(patients[handle]->getPhoneNumber(), handle);
+    }
+}
+
+// Brings the patients' own appointment dates in line with a cancel or shift.
+// A patient whose recorded appointment moved follows it; one whose
+// appointment was cancelled falls back to their next booking, if any.
+void applyRescheduleNotices(const vector<unique_ptr<Patient>>& patients, PatientHistory& history,
+                            const AppointmentBook& appointments, const vector<RescheduleNotice>& notices) {
+    for (const auto& notice : notices) {
+        auto it = find_if(patients.begin(), patients.end(),
+                          [&](const unique_ptr<Patient>& p){ return p->matchesName(notice.patientName); });
+        if (it == patients.end() || !(*it)->hasAppointment()
+            || formatDateTime((*it)->getAppointmentMinutes()) != notice.oldDateTime) {
+            continue;
+        }
+        patientViews.forget((*it)->getRevision());
+        if (!notice.newDateTime.empty()) {
+            (*it)->setAppointment(true, packDateTime(notice.newDateTime));
+        } else {
+            const Appointment* next = appointments.nextFor(notice.patientName, notice.oldDateTime);
+            Parsed<uint32_t> minutes = next ? parseDateTime(next->getDateAndTime()) : Parsed<uint32_t>{ 0, ParseError::Empty };
+            (*it)->setAppointment(minutes.ok(), minutes.value);
+        }
+        history.record(it - patients.begin(), **it);
+        shareAppointmentDate(**it);
+    }
+}
+
+// Disk patient registry: a B+-tree of fixed 4 KiB pages keyed by (name, id)
+// and read through a bounded buffer pool, so the registry can outgrow
+// memory. Page 0 holds the tree metadata; a lookup costs at most one page
+// read per tree level.
+constexpr size_t registryPageSize = 4096;
+constexpr uint32_t noPage = numeric_limits<uint32_t>::max();
+
+struct RegistryKey {
+    char name[24];   // zero-padded, so memcmp orders names lexicographically
+    uint32_t id;
+};
+
+int compareKeys(const RegistryKey& a, const RegistryKey& b) {
+    int order = memcmp(a.name, b.name, sizeof(a.name));
+    if (order != 0) return order;
+    return a.id < b.id ? -1 : (a.id > b.id ? 1 : 0);
+}
+
+bool keyBefore(const RegistryKey& a, const RegistryKey& b) {
+    return compareKeys(a, b) < 0;
+}
+
+RegistryKey makeRegistryKey(const string& name, uint32_t id) {
+    RegistryKey key{};
+    if (name.size() > sizeof(key.name)) {
+        throw InvalidInputException("Registry names are limited to " + to_string(sizeof(key.name)) + " characters.");
+    }
+    memcpy(key.name, name.data(), name.size());
+    key.id = id;
+    return key;
+}
+
+struct StoredPatient {
+    RegistryKey key;
+    uint32_t previousAdmittances;
+    double paymentDue;
+    uint64_t phoneNumber;
+    uint32_t appointmentMinutes;
+    uint32_t hasAppointment;
+};
+
+struct RegistryMeta {
+    uint64_t magic;
+    uint32_t pageCount;
+    uint32_t root;
+    uint32_t height;
+    uint32_t nextId;
+    uint64_t recordCount;
+};
+
+struct NodeHeader {
+    uint16_t leaf;
+    uint16_t count;
+    uint32_t next;   // right sibling of a leaf; 0 ends the chain
+    uint64_t reserved;
+};
+
+constexpr size_t leafCapacity = (registryPageSize - sizeof(NodeHeader)) / sizeof(StoredPatient);
+constexpr size_t branchCapacity = (registryPageSize - sizeof(NodeHeader) - sizeof(uint32_t)) / (sizeof(RegistryKey) + sizeof(uint32_t));
+
+struct LeafNode {
+    NodeHeader header;
+    StoredPatient records[leafCapacity];
+};
+
+// children[i] holds keys below keys[i]; children[count] holds the rest
+struct BranchNode {
+    NodeHeader header;
+    RegistryKey keys[branchCapacity];
+    uint32_t children[branchCapacity + 1];
+};
+
+static_assert(sizeof(LeafNode) <= registryPageSize, "Leaf must fit in a page");
+static_assert(sizeof(BranchNode) <= registryPageSize, "Branch must fit in a page");
+static_assert(sizeof(RegistryMeta) <= registryPageSize, "Metadata must fit in a page");
+
+// Fixed set of page frames over a file, replaced by the clock algorithm.
+// Pinned frames are never evicted; dirty frames are written back on eviction.
+class BufferPool {
+private:
+    struct Frame {
+        uint32_t page;
+        int pins;
+        bool dirty;
+        bool referenced;
+    };
+
+    int fd;
+    vector<Frame> frames;
+    unique_ptr<char[]> memory;
+    unordered_map<uint32_t, size_t> resident;
+    size_t hand;
+
+    void transfer(uint32_t page, char* data, bool write) {
+        off_t offset = static_cast<off_t>(page) * registryPageSize;
+        size_t done = 0;
+        while (done < registryPageSize) {
+            ssize_t count = write ? pwrite(fd, data + done, registryPageSize - done, offset + done)
+                                  : pread(fd, data + done, registryPageSize - done, offset + done);
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0) throw runtime_error(string("Registry I/O failed: ") + strerror(errno));
+            if (count == 0) {
+                memset(data + done, 0, registryPageSize - done);
+                break;
+            }
+            done += count;
+        }
+        ++(write ? pageWrites : pageReads);
+    }
+
+    size_t victim() {
+        for (size_t step = 0; step < 2 * frames.size(); ++step) {
+            size_t candidate = hand;
+            hand = (hand + 1) % frames.size();
+            Frame& frame = frames[candidate];
+            if (frame.pins > 0) continue;
+            if (frame.referenced) {
+                frame.referenced = false;
+                continue;
+            }
+            if (frame.page != noPage) {
+                if (frame.dirty) transfer(frame.page, data(candidate), true);
+                resident.erase(frame.page);
+            }
+            return candidate;
+        }
+        throw runtime_error("Buffer pool exhausted: every frame is pinned.");
+    }
+
+public:
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t pageReads = 0;
+    uint64_t pageWrites = 0;
+
+    BufferPool(int file, size_t frameCount)
+        : fd(file), frames(frameCount, Frame{ noPage, 0, false, false }),
+          memory(new char[frameCount * registryPageSize]), hand(0) {
+        resident.reserve(frameCount);
+    }
+
+    // Pins a page and returns its frame; a fresh page starts zeroed and unread
+    size_t pin(uint32_t page, bool fresh) {
+        auto found = resident.find(page);
+        if (found != resident.end()) {
+            ++hits;
+            Frame& frame = frames[found->second];
+            ++frame.pins;
+            frame.referenced = true;
+            return found->second;
+        }
+        ++misses;
+        size_t slot = victim();
+        if (fresh) {
+            memset(data(slot), 0, registryPageSize);
+        } else {
+            transfer(page, data(slot), false);
+        }
+        frames[slot] = Frame{ page, 1, fresh, true };
+        resident[page] = slot;
+        return slot;
+    }
+
+    void unpin(size_t frame) {
+        --frames[frame].pins;
+    }
+
+    void markDirty(size_t frame) {
+        frames[frame].dirty = true;
+    }
+
+    char* data(size_t frame) {
+        return memory.get() + frame * registryPageSize;
+    }
+
+    void flush() {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (frames[i].page != noPage && frames[i].dirty) {
+                transfer(frames[i].page, data(i), true);
+                frames[i].dirty = false;
+            }
+        }
+    }
+
+    size_t frameCount() const {
+        return frames.size();
+    }
+};
+
+class PageGuard {
+private:
+    BufferPool& pool;
+    size_t frame;
+
+public:
+    PageGuard(BufferPool& p, uint32_t page, bool fresh = false) : pool(p), frame(p.pin(page, fresh)) {}
+    ~PageGuard() { pool.unpin(frame); }
+
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+
+    template <typename Node>
+    const Node& read() {
+        return *reinterpret_cast<const Node*>(pool.data(frame));
+    }
+
+    template <typename Node>
+    Node& write() {
+        pool.markDirty(frame);
+        return *reinterpret_cast<Node*>(pool.data(frame));
+    }
+};
+
+class PatientStore {
+private:
+    static constexpr uint64_t magicNumber = 0x3159525453494752ULL;   // "RGISTRY1"
+
+    int fd;
+    unique_ptr<BufferPool> pool;
+    RegistryMeta meta;
+
+    uint32_t allocatePage() {
+        return meta.pageCount++;
+    }
+
+    // Descends to the leaf that would hold key, noting the branches passed
+    uint32_t findLeaf(const RegistryKey& key, vector<uint32_t>* path) {
+        uint32_t page = meta.root;
+        for (uint32_t level = 1; level < meta.height; ++level) {
+            if (path) path->push_back(page);
+            PageGuard guard(*pool, page);
+            const BranchNode& node = guard.read<BranchNode>();
+            size_t slot = upper_bound(node.keys, node.keys + node.header.count, key, keyBefore) - node.keys;
+            page = node.children[slot];
+        }
+        return page;
+    }
+
+    void insertIntoParent(vector<uint32_t>& path, RegistryKey separator, uint32_t right) {
+        while (!path.empty()) {
+            uint32_t page = path.back();
+            path.pop_back();
+            PageGuard guard(*pool, page);
+            BranchNode& node = guard.write<BranchNode>();
+            size_t count = node.header.count;
+            size_t slot = upper_bound(node.keys, node.keys + count, separator, keyBefore) - node.keys;
+
+            if (count < branchCapacity) {
+                memmove(&node.keys[slot + 1], &node.keys[slot], (count - slot) * sizeof(RegistryKey));
+                memmove(&node.children[slot + 2], &node.children[slot + 1], (count - slot) * sizeof(uint32_t));
+                node.keys[slot] = separator;
+                node.children[slot + 1] = right;
+                ++node.header.count;
+                return;
+            }
+
+            RegistryKey keys[branchCapacity + 1];
+            uint32_t children[branchCapacity + 2];
+            copy(node.keys, node.keys + slot, keys);
+            keys[slot] = separator;
+            copy(node.keys + slot, node.keys + count, keys + slot + 1);
+            copy(node.children, node.children + slot + 1, children);
+            children[slot + 1] = right;
+            copy(node.children + slot + 1, node.children + count + 1, children + slot + 2);
+
+            // The middle key moves up; each half keeps the children around it
+            size_t middle = (branchCapacity + 1) / 2;
+            uint32_t sibling = allocatePage();
+            PageGuard siblingGuard(*pool, sibling, true);
+            BranchNode& upper = siblingGuard.write<BranchNode>();
+            node.header.count = static_cast<uint16_t>(middle);
+            copy(keys, keys + middle, node.keys);
+            copy(children, children + middle + 1, node.children);
+            upper.header = NodeHeader{ 0, static_cast<uint16_t>(branchCapacity - middle), 0, 0 };
+            copy(keys + middle + 1, keys + branchCapacity + 1, upper.keys);
+            copy(children + middle + 1, children + branchCapacity + 2, upper.children);
+
+            separator = keys[middle];
+            right = sibling;
+        }
+
+        uint32_t root = allocatePage();
+        PageGuard guard(*pool, root, true);
+        BranchNode& node = guard.write<BranchNode>();
+        node.header = NodeHeader{ 0, 1, 0, 0 };
+        node.keys[0] = separator;
+        node.children[0] = meta.root;
+        node.children[1] = right;
+        meta.root = root;
+        ++meta.height;
+    }
+
+    // Visits records in key order from the first key not below from,
+    // until visit returns false
+    template <typename Visitor>
+    void scanFrom(const RegistryKey& from, Visitor visit) {
+        uint32_t page = findLeaf(from, nullptr);
+        bool first = true;
+        while (page != 0) {
+            PageGuard guard(*pool, page);
+            const LeafNode& leaf = guard.read<LeafNode>();
+            size_t slot = 0;
+            if (first) {
+                auto before = [](const StoredPatient& record, const RegistryKey& key) { return keyBefore(record.key, key); };
+                slot = lower_bound(leaf.records, leaf.records + leaf.header.count, from, before) - leaf.records;
+                first = false;
+            }
+            for (; slot < leaf.header.count; ++slot) {
+                if (!visit(leaf.records[slot])) return;
+            }
+            page = leaf.header.next;
+        }
+    }
+
+    static Patient toPatient(const StoredPatient& record) {
+        string name(record.key.name, strnlen(record.key.name, sizeof(record.key.name)));
+        return Patient(name, record.previousAdmittances, record.paymentDue, record.hasAppointment != 0,
+                       record.hasAppointment ? formatDateTime(record.appointmentMinutes) : "",
+                       formatPhoneNumber(record.phoneNumber));
+    }
+
+public:
+    PatientStore(const string& path, size_t poolFrames) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) throw runtime_error("Cannot open registry " + path + ": " + strerror(errno));
+        pool = make_unique<BufferPool>(fd, max<size_t>(poolFrames, 16));
+
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size == 0) {
+            meta = RegistryMeta{ magicNumber, 2, 1, 1, 0, 0 };
+            PageGuard guard(*pool, meta.root, true);
+            guard.write<LeafNode>().header = NodeHeader{ 1, 0, 0, 0 };
+        } else {
+            PageGuard guard(*pool, 0);
+            meta = guard.read<RegistryMeta>();
+            if (meta.magic != magicNumber) {
+                close(fd);
+                throw runtime_error(path + " is not a patient registry.");
+            }
+        }
+    }
+
+    PatientStore(const PatientStore&) = delete;
+    PatientStore& operator=(const PatientStore&) = delete;
+
+    ~PatientStore() {
+        try {
+            flush();
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+        }
+        close(fd);
+    }
+
+    uint32_t insert(const Patient& patient) {
+        StoredPatient record{ makeRegistryKey(patient.getName(), meta.nextId),
+                              static_cast<uint32_t>(patient.getPreviousAdmittances()), patient.getPaymentDue(),
+                              patient.getPhoneNumber(), patient.getAppointmentMinutes(), patient.hasAppointment() };
+        vector<uint32_t> path;
+        uint32_t leafPage = findLeaf(record.key, &path);
+        RegistryKey separator;
+        uint32_t sibling = 0;
+        {
+            PageGuard guard(*pool, leafPage);
+            LeafNode& leaf = guard.write<LeafNode>();
+            size_t count = leaf.header.count;
+            auto before = [](const StoredPatient& stored, const RegistryKey& key) { return keyBefore(stored.key, key); };
+            size_t slot = lower_bound(leaf.records, leaf.records + count, record.key, before) - leaf.records;
+
+            if (count < leafCapacity) {
+                memmove(&leaf.records[slot + 1], &leaf.records[slot], (count - slot) * sizeof(StoredPatient));
+                leaf.records[slot] = record;
+                ++leaf.header.count;
+            } else {
+                StoredPatient records[leafCapacity + 1];
+                copy(leaf.records, leaf.records + slot, records);
+                records[slot] = record;
+                copy(leaf.records + slot, leaf.records + count, records + slot + 1);
+
+                size_t lowerCount = (leafCapacity + 1) / 2;
+                sibling = allocatePage();
+                PageGuard siblingGuard(*pool, sibling, true);
+                LeafNode& upper = siblingGuard.write<LeafNode>();
+                upper.header = NodeHeader{ 1, static_cast<uint16_t>(leafCapacity + 1 - lowerCount), leaf.header.next, 0 };
+                copy(records + lowerCount, records + leafCapacity + 1, upper.records);
+                copy(records, records + lowerCount, leaf.records);
+                leaf.header.count = static_cast<uint16_t>(lowerCount);
+                leaf.header.next = sibling;
+                separator = upper.records[0].key;
+            }
+        }
+        if (sibling != 0) insertIntoParent(path, separator, sibling);
+
+        ++meta.recordCount;
+        return meta.nextId++;
+    }
+
+    // Visits every patient with exactly this name, in id order
+    template <typename Visitor>
+    size_t findByName(const string& name, Visitor visit) {
+        RegistryKey from = makeRegistryKey(name, 0);
+        size_t found = 0;
+        scanFrom(from, [&](const StoredPatient& record) {
+            if (memcmp(record.key.name, from.name, sizeof(from.name)) != 0) return false;
+            visit(record.key.id, toPatient(record));
+            ++found;
+            return true;
+        });
+        return found;
+    }
+
+    // Whether a patient with this name and phone number is already stored
+    bool contains(const string& name, uint64_t phoneNumber) {
+        RegistryKey from = makeRegistryKey(name, 0);
+        bool found = false;
+        scanFrom(from, [&](const StoredPatient& record) {
+            if (memcmp(record.key.name, from.name, sizeof(from.name)) != 0) return false;
+            found = record.phoneNumber == phoneNumber;
+            return !found;
+        });
+        return found;
+    }
+
+    // Visits up to limit patients with names in [from, to], in name order
+    template <typename Visitor>
+    size_t scanNames(const string& from, const string& to, size_t limit, Visitor visit) {
+        RegistryKey last = makeRegistryKey(to, 0);
+        size_t found = 0;
+        scanFrom(makeRegistryKey(from, 0), [&](const StoredPatient& record) {
+            if (found == limit || memcmp(record.key.name, last.name, sizeof(last.name)) > 0) return false;
+            visit(record.key.id, toPatient(record));
+            ++found;
+            return true;
+        });
+        return found;
+    }
+
+    void flush() {
+        {
+            PageGuard guard(*pool, 0);
+            guard.write<RegistryMeta>() = meta;
+        }
+        pool->flush();
+        if (fdatasync(fd) != 0) throw runtime_error(string("Registry sync failed: ") + strerror(errno));
+    }
+
+    const BufferPool& bufferPool() const {
+        return *pool;
+    }
+
+    uint64_t recordCount() const {
+        return meta.recordCount;
+    }
+
+    uint32_t height() const {
+        return meta.height;
+    }
+
+    uint32_t pageCount() const {
+        return meta.pageCount;
+    }
+};
+
+// Set while a registry file is open: new patients are written through to it,
+// and name searches that miss the in-memory list fall back to it
+PatientStore* openRegistry = nullptr;
+
+void storePatient(const Patient& patient) {
+    if (!openRegistry) return;
+    string name = patient.getName();
+    if (name.size() > sizeof(RegistryKey::name)) {
+        cerr << "Registry not updated: names are limited to " << sizeof(RegistryKey::name) << " characters." << endl;
+        return;
+    }
+    try {
+        if (!openRegistry->contains(name, patient.getPhoneNumber())) openRegistry->insert(patient);
+    } catch (const runtime_error& e) {
+        cerr << "Registry not updated: " << e.what() << endl;
+    }
+}
+
+// Patient segments split a saved table by access frequency. The hot
+// segment holds what dues totals, appointment checks and name lookups
+// need and is loaded whole; the cold segment holds fixed-size records of
+// phone number and appointment time, read one at a time on first use.
+struct ColdPatientFields {
+    uint64_t phoneNumber;
+    uint32_t appointmentMinutes;
+    uint32_t reserved;
+};
+
+constexpr uint64_t hotSegmentMagic = 0x31544f4854415048ULL;    // "HPATHOT1"
+constexpr uint64_t coldSegmentMagic = 0x31444c4f43544150ULL;   // "PATCOLD1"
+constexpr size_t segmentHeaderBytes = 2 * sizeof(uint64_t);
+
+void writePatientSegments(const string& basePath, const vector<unique_ptr<Patient>>& patients) {
+    ofstream hot(basePath + ".hot", ios::binary | ios::trunc);
+    ofstream cold(basePath + ".cold", ios::binary | ios::trunc);
+    if (!hot || !cold) throw runtime_error("Cannot create segments at " + basePath + ".");
+
+    uint64_t header[2] = { hotSegmentMagic, patients.size() };
+    hot.write(reinterpret_cast<const char*>(header), sizeof(header));
+    header[0] = coldSegmentMagic;
+    cold.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (const auto& patient : patients) {
+        const CompactString& name = patient->getCompactName();
+        uint32_t nameLength = static_cast<uint32_t>(name.size());
+        double paymentDue = patient->getPaymentDue();
+        uint32_t status = static_cast<uint32_t>(patient->getPreviousAdmittances()) << 1 | (patient->hasAppointment() ? 1 : 0);
+        hot.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        hot.write(name.data(), nameLength);
+        hot.write(reinterpret_cast<const char*>(&paymentDue), sizeof(paymentDue));
+        hot.write(reinterpret_cast<const char*>(&status), sizeof(status));
+
+        ColdPatientFields fields{ patient->getPhoneNumber(), patient->getAppointmentMinutes(), 0 };
+        cold.write(reinterpret_cast<const char*>(&fields), sizeof(fields));
+    }
+    if (!hot.flush() || !cold.flush()) throw runtime_error("Cannot write segments at " + basePath + ".");
+}
+
+// Patient table loaded from segments with only the hot fields resident.
+// Cold fields are fetched by handle and kept in a bounded LRU cache.
+class LazyPatientTable {
+private:
+    struct HotPatient {
+        CompactString name;
+        double paymentDue;
+        uint32_t status;   // previous admittances above the has-appointment bit
+    };
+
+    vector<HotPatient> hot;
+    vector<uint32_t> byName;   // handles in name order, equal names by handle
+    int coldFd;
+    size_t capacity;
+    list<pair<uint32_t, ColdPatientFields>> recent;   // most recently used first
+    unordered_map<uint32_t, list<pair<uint32_t, ColdPatientFields>>::iterator> cached;
+
+    string_view nameOf(uint32_t handle) const {
+        return string_view(hot[handle].name.data(), hot[handle].name.size());
+    }
+
+    ColdPatientFields readColdFields(uint32_t handle) {
+        ColdPatientFields fields;
+        off_t offset = segmentHeaderBytes + static_cast<off_t>(handle) * sizeof(fields);
+        if (pread(coldFd, &fields, sizeof(fields), offset) != static_cast<ssize_t>(sizeof(fields))) {
+            throw runtime_error("Cold segment is truncated.");
+        }
+        return fields;
+    }
+
+public:
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    LazyPatientTable(const string& basePath, size_t cacheEntries) : capacity(max<size_t>(cacheEntries, 1)) {
+        ifstream in(basePath + ".hot", ios::binary);
+        if (!in) throw runtime_error("Cannot open " + basePath + ".hot.");
+        uint64_t header[2];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != hotSegmentMagic) {
+            throw runtime_error(basePath + ".hot is not a hot patient segment.");
+        }
+
+        hot.reserve(header[1]);
+        string name;
+        for (uint64_t i = 0; i < header[1]; ++i) {
+            uint32_t nameLength;
+            double paymentDue;
+            uint32_t status;
+            in.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
+            name.resize(nameLength);
+            in.read(&name[0], nameLength);
+            in.read(reinterpret_cast<char*>(&paymentDue), sizeof(paymentDue));
+            in.read(reinterpret_cast<char*>(&status), sizeof(status));
+            if (!in) throw runtime_error(basePath + ".hot is truncated.");
+            hot.push_back({ CompactString(name), paymentDue, status });
+        }
+        byName.resize(hot.size());
+        iota(byName.begin(), byName.end(), 0);
+        stable_sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) { return nameOf(a) < nameOf(b); });
+
+        coldFd = open((basePath + ".cold").c_str(), O_RDONLY);
+        if (coldFd < 0) throw runtime_error("Cannot open " + basePath + ".cold: " + strerror(errno));
+        cached.reserve(capacity);
+    }
+
+    LazyPatientTable(const LazyPatientTable&) = delete;
+    LazyPatientTable& operator=(const LazyPatientTable&) = delete;
+
+    ~LazyPatientTable() {
+        close(coldFd);
+    }
+
+    size_t size() const {
+        return hot.size();
+    }
+
+    const ColdPatientFields& coldFields(uint32_t handle) {
+        auto found = cached.find(handle);
+        if (found != cached.end()) {
+            ++hits;
+            recent.splice(recent.begin(), recent, found->second);
+            return found->second->second;
+        }
+        ++misses;
+        if (recent.size() == capacity) {
+            cached.erase(recent.back().first);
+            recent.pop_back();
+        }
+        recent.emplace_front(handle, readColdFields(handle));
+        cached[handle] = recent.begin();
+        return recent.front().second;
+    }
+
+    Patient materialize(uint32_t handle) {
+        const HotPatient& record = hot[handle];
+        const ColdPatientFields& fields = coldFields(handle);
+        bool appointment = (record.status & 1) != 0;
+        return Patient(record.name.str(), static_cast<int>(record.status >> 1), record.paymentDue, appointment,
+                       appointment ? formatDateTime(fields.appointmentMinutes) : "", formatPhoneNumber(fields.phoneNumber));
+    }
+
+    // Binary search of the name order; the lowest handle wins among equal names
+    bool findByName(const string& name, uint32_t& handle) const {
+        auto it = lower_bound(byName.begin(), byName.end(), string_view(name),
+                              [&](uint32_t candidate, string_view key) { return nameOf(candidate) < key; });
+        if (it == byName.end() || nameOf(*it) != name) return false;
+        handle = *it;
+        return true;
+    }
+
+    double totalDues() const {
+        double total = 0;
+        for (const auto& record : hot) total += record.paymentDue;
+        return total;
+    }
+
+    size_t appointmentCount() const {
+        size_t count = 0;
+        for (const auto& record : hot) count += record.status & 1;
+        return count;
+    }
+
+    size_t residentBytes() const {
+        size_t bytes = hot.capacity() * sizeof(HotPatient) + byName.capacity() * sizeof(byName[0]);
+        for (const auto& record : hot) bytes += record.name.heapBytes();
+        // List node plus hash node and bucket per cached entry
+        bytes += recent.size() * (sizeof(pair<uint32_t, ColdPatientFields>) + 2 * sizeof(void*))
+               + cached.size() * (sizeof(uint32_t) + 2 * sizeof(void*)) + cached.bucket_count() * sizeof(void*);
+        return bytes;
+    }
+
+    size_t cachedEntries() const {
+        return recent.size();
+    }
+
+    size_t cacheCapacity() const {
+        return capacity;
+    }
+};
+
+// Set while segments are loaded: name searches that miss the in-memory list
+// are answered from the hot fields, touching the cold segment only for a match.
+// The in-memory list stays fully loaded because the handlers edit its records
+// in place; a roster saved to segments is what gets served lazily.
+LazyPatientTable* loadedPatients = nullptr;
+
+struct FormularyItem {
+    string_view name;
+    int initialStock;
+};
+
+// The standard formulary. Items here live in fixed array slots; anything
+// added through addItem() that is not listed goes to an overflow table.
+constexpr FormularyItem formulary[] = {
+    { "B+ Blood bags", 12 },
+    { "A+ Blood bags", 0 },
+    { "O+ Blood bags", 40 },
+    { "Syringes", 3300 },
+    { "Crocin", 4500 },
+    { "Hydrochloroquine", 100 },
+};
+
+constexpr size_t formularySize = sizeof(formulary) / sizeof(formulary[0]);
+
+// Samples the length and three characters rather than hashing the whole name;
+// buildFormularyTable() fails to compile if that stops telling items apart.
+constexpr uint32_t formularyHash(string_view name, uint32_t seed) {
+    uint32_t key = static_cast<uint32_t>(name.size());
+    if (!name.empty()) {
+        key ^= static_cast<uint32_t>(static_cast<unsigned char>(name[0])) << 8;
+        key ^= static_cast<uint32_t>(static_cast<unsigned char>(name[name.size() / 2])) << 16;
+        key ^= static_cast<uint32_t>(static_cast<unsigned char>(name[name.size() - 1])) << 24;
+    }
+    return (key ^ seed) * 0x9E3779B1u;
+}
+
+constexpr size_t formularySlotBits = 4;
+constexpr size_t formularySlots = size_t(1) << formularySlotBits;
+static_assert(formularySlots >= formularySize, "formularySlotBits is too small for the formulary");
+
+constexpr size_t formularySlotOf(string_view name, uint32_t seed) {
+    return formularyHash(name, seed) >> (32 - formularySlotBits);
+}
+
+struct FormularyTable {
+    uint32_t seed;
+    int8_t slots[formularySlots];
+};
+
+// Searches for a seed under which every formulary name hashes to its own slot
+constexpr FormularyTable buildFormularyTable() {
+    for (uint32_t seed = 0;; ++seed) {
+        if (seed == 1u << 20) throw logic_error("No perfect hash seed for the formulary");
+        FormularyTable table = { seed, {} };
+        for (auto& slot : table.slots) slot = -1;
+        bool collision = false;
+        for (size_t i = 0; i < formularySize && !collision; ++i) {
+            int8_t& slot = table.slots[formularySlotOf(formulary[i].name, seed)];
+            if (slot >= 0) collision = true;
+            else slot = static_cast<int8_t>(i);
+        }
+        if (!collision) return table;
+    }
+}
+
+constexpr FormularyTable formularyTable = buildFormularyTable();
+
+// Formulary index of an item, or -1 if it is not in the formulary
+constexpr int formularySlot(string_view name) {
+    int slot = formularyTable.slots[formularySlotOf(name, formularyTable.seed)];
+    return slot >= 0 && name == formulary[slot].name ? slot : -1;
+}
+
+static_assert(formularySlot("Syringes") == 3, "formulary perfect hash is broken");
+static_assert(formularySlot("Paracetamol") == -1, "formulary perfect hash is broken");
+
+// Mutations are appended to an in-memory ring as compact binary events, and a
+// background thread writes them to disk in batches so the menu thread never
+// waits on I/O. The menu thread is the only producer and the writer thread the
+// only consumer, so the two ring positions need no lock.
+enum class MutationType : uint8_t { Padding, PatientAdded, AppointmentAdded, StockRemoved };
+
+constexpr uint64_t mutationLogMagic = 0x31474F4C5441554DULL;   // "MUTALOG1"
+constexpr size_t maxEventText = 255;
+constexpr size_t maxEventBytes = 1024;
+
+// Record layout: uint16 length (padded to 4 bytes), uint8 type, uint64
+// microseconds since the epoch, then the fields of the type. Text is a uint8
+// length and the bytes, cut at maxEventText.
+class EventEncoder {
+private:
+    char buffer[maxEventBytes];
+    size_t length;
+
+public:
+    EventEncoder(MutationType type) : length(sizeof(uint16_t)) {
+        put(static_cast<uint8_t>(type));
+        put(static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(
+            chrono::system_clock::now().time_since_epoch()).count()));
+    }
+
+    template <typename T>
+    void put(T value) {
+        memcpy(buffer + length, &value, sizeof(value));
+        length += sizeof(value);
+    }
+
+    void putText(string_view text) {
+        uint8_t size = static_cast<uint8_t>(min(text.size(), maxEventText));
+        put(size);
+        memcpy(buffer + length, text.data(), size);
+        length += size;
+    }
+
+    // Pads and stamps the record; returns its bytes
+    string_view finish() {
+        while (length % 4 != 0) buffer[length++] = 0;
+        uint16_t size = static_cast<uint16_t>(length);
+        memcpy(buffer, &size, sizeof(size));
+        return string_view(buffer, length);
+    }
+};
+
+class MutationLog {
+private:
+    int fd;
+    bool inlineWrites;
+    size_t capacity;
+    unique_ptr<char[]> ring;
+    alignas(64) atomic<uint64_t> head;   // written by the producer
+    alignas(64) atomic<uint64_t> tail;   // written by the consumer
+    alignas(64) uint64_t cachedTail;     // producer's last view of tail
+    atomic<bool> running;
+    atomic<int> writeError;
+    thread writer;
+
+    // False once a write has failed; nothing more is written after that
+    bool writeAll(const char* data, size_t size) {
+        if (writeError.load() != 0) return false;
+        while (size > 0) {
+            ssize_t count = ::write(fd, data, size);
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0) {
+                writeError.store(errno);
+                return false;
+            }
+            data += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    void countBatch(uint64_t events, size_t bytes, bool written) {
+        if (written) {
+            eventsWritten.fetch_add(events, memory_order_relaxed);
+            bytesWritten.fetch_add(bytes, memory_order_relaxed);
+            batches.fetch_add(1, memory_order_relaxed);
+        } else {
+            eventsDropped.fetch_add(events, memory_order_relaxed);
+            bytesDropped.fetch_add(bytes, memory_order_relaxed);
+            batchesDropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    // Moves everything in the ring into one batch and writes it
+    bool drain(string& batch) {
+        uint64_t position = tail.load(memory_order_relaxed);
+        uint64_t end = head.load(memory_order_acquire);
+        if (position == end) return false;
+
+        batch.clear();
+        uint64_t events = 0;
+        while (position < end) {
+            const char* record = ring.get() + (position & (capacity - 1));
+            uint16_t size;
+            memcpy(&size, record, sizeof(size));
+            if (static_cast<MutationType>(record[sizeof(size)]) != MutationType::Padding) {
+                batch.append(record, size);
+                ++events;
+            }
+            position += size;
+        }
+        tail.store(position, memory_order_release);
+
+        countBatch(events, batch.size(), writeAll(batch.data(), batch.size()));
+        return true;
+    }
+
+    void consume() {
+        string batch;
+        while (running.load(memory_order_acquire)) {
+            if (!drain(batch)) this_thread::sleep_for(chrono::microseconds(500));
+        }
+        drain(batch);
+    }
+
+    uint64_t freeBytes() const {
+        return capacity - (head.load(memory_order_relaxed) - cachedTail);
+    }
+
+public:
+    // Producer-side counters
+    uint64_t eventsEmitted = 0;
+    uint64_t bytesEmitted = 0;
+    uint64_t stalls = 0;
+    uint64_t stallNanoseconds = 0;
+    uint64_t peakOccupancy = 0;
+    // Consumer-side counters
+    atomic<uint64_t> eventsWritten{ 0 };
+    atomic<uint64_t> bytesWritten{ 0 };
+    atomic<uint64_t> batches{ 0 };
+    // Batches lost because the log could no longer be written
+    atomic<uint64_t> eventsDropped{ 0 };
+    atomic<uint64_t> bytesDropped{ 0 };
+    atomic<uint64_t> batchesDropped{ 0 };
+
+    // ringBytes is rounded up to a power of two. With inlineWrites every event
+    // is written on the caller's thread instead, for comparison.
+    MutationLog(const string& path, size_t ringBytes, bool inline_ = false)
+        : fd(-1), inlineWrites(inline_), capacity(maxEventBytes), head(0), tail(0), cachedTail(0),
+          running(false), writeError(0) {
+        while (capacity < ringBytes) capacity <<= 1;
+        ring.reset(new char[capacity]);
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw runtime_error("Cannot open event log " + path + ": " + strerror(errno));
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size == 0) writeAll(reinterpret_cast<const char*>(&mutationLogMagic), sizeof(mutationLogMagic));
+        if (!inlineWrites) {
+            running.store(true);
+            writer = thread(&MutationLog::consume, this);
+        }
+    }
+
+    ~MutationLog() {
+        stop();
+        close(fd);
+    }
+
+    // Writes out what is left in the ring and stops the writer thread
+    void stop() {
+        if (writer.joinable()) {
+            running.store(false, memory_order_release);
+            writer.join();
+        }
+    }
+
+    MutationLog(const MutationLog&) = delete;
+    MutationLog& operator=(const MutationLog&) = delete;
+
+    // Copies one encoded event into the ring. When the ring is full the
+    // producer waits for the writer to free space and the wait is counted.
+    void push(string_view record) {
+        ++eventsEmitted;
+        bytesEmitted += record.size();
+        if (inlineWrites) {
+            countBatch(1, record.size(), writeAll(record.data(), record.size()));
+            return;
+        }
+
+        uint64_t position = head.load(memory_order_relaxed);
+        size_t offset = position & (capacity - 1);
+        size_t contiguous = capacity - offset;
+        size_t needed = record.size() + (contiguous < record.size() ? contiguous : 0);
+        if (freeBytes() < needed) {
+            cachedTail = tail.load(memory_order_acquire);
+            if (freeBytes() < needed) {
+                ++stalls;
+                auto start = chrono::steady_clock::now();
+                while (freeBytes() < needed) {
+                    this_thread::yield();
+                    cachedTail = tail.load(memory_order_acquire);
+                }
+                stallNanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        // A record never wraps; the tail of the ring is filled with padding instead
+        if (contiguous < record.size()) {
+            uint16_t size = static_cast<uint16_t>(contiguous);
+            memcpy(ring.get() + offset, &size, sizeof(size));
+            ring[offset + sizeof(size)] = static_cast<char>(MutationType::Padding);
+            position += contiguous;
+            offset = 0;
+        }
+        memcpy(ring.get() + offset, record.data(), record.size());
+        position += record.size();
+        head.store(position, memory_order_release);
+        peakOccupancy = max(peakOccupancy, position - cachedTail);
+    }
+
+    uint64_t pendingBytes() const {
+        return head.load(memory_order_relaxed) - tail.load(memory_order_acquire);
+    }
+
+    size_t ringBytes() const {
+        return capacity;
+    }
+
+    int error() const {
+        return writeError.load();
+    }
+};
+
+// Set while an event log is running; mutations report to it
+MutationLog* mutationLog = nullptr;
+
+void logPatientAdded(const Patient& patient) {
+    if (!mutationLog) return;
+    EventEncoder event(MutationType::PatientAdded);
+    event.putText(patient.getName());
+    event.put(patient.getPhoneNumber());
+    event.put(static_cast<uint32_t>(patient.getPreviousAdmittances()));
+    event.put(patient.getPaymentDue());
+    event.put(patient.hasAppointment() ? patient.getAppointmentMinutes() : 0u);
+    mutationLog->push(event.finish());
+}
+
+void logAppointmentAdded(const string& patient, const string& dateTime, const string& doctor) {
+    if (!mutationLog) return;
+    EventEncoder event(MutationType::AppointmentAdded);
+    event.putText(patient);
+    event.putText(doctor);
+    event.put(packDateTime(dateTime));
+    mutationLog->push(event.finish());
+}
+
+void logStockRemoved(const string& itemName, int quantity, int remaining) {
+    if (!mutationLog) return;
+    EventEncoder event(MutationType::StockRemoved);
+    event.putText(itemName);
+    event.put(static_cast<int32_t>(quantity));
+    event.put(static_cast<int32_t>(remaining));
+    mutationLog->push(event.finish());
+}
+
+// Hourly consumption of one item over the last week, in a ring of buckets
+// indexed by hour. The window total is adjusted as buckets enter and leave and
+// the daily rate is refreshed on every removal, so reading it costs nothing
+// unless hours have passed since the item was last touched.
+class ConsumptionSeries {
+public:
+    static constexpr uint32_t windowHours = 168;
+    // A young series is averaged over at least a day, so one busy first hour
+    // is not read as the rate for the whole day.
+    static constexpr uint32_t minimumHours = 24;
+
+private:
+    uint32_t buckets[windowHours];
+    uint32_t firstHour;
+    uint32_t newestHour;
+    uint64_t windowTotal;
+    double rate;   // per day, as of newestHour
+
+    double rateFor(uint64_t total, uint32_t hour) const {
+        uint32_t span = hour >= firstHour ? hour - firstHour + 1 : 1;
+        return total * 24.0 / clamp(span, minimumHours, windowHours);
+    }
+
+    // Window total as of a later hour, leaving out the buckets that expired meanwhile
+    uint64_t totalAt(uint32_t hour) const {
+        if (hour <= newestHour) return windowTotal;
+        if (hour - newestHour >= windowHours) return 0;
+        uint64_t total = windowTotal;
+        for (uint32_t h = newestHour + 1; h <= hour; ++h) {
+            total -= buckets[h % windowHours];
+        }
+        return total;
+    }
+
+public:
+    ConsumptionSeries(uint32_t hour = currentMinutes() / 60)
+        : buckets{}, firstHour(hour), newestHour(hour), windowTotal(0), rate(0) {}
+
+    void record(uint32_t hour, uint32_t quantity) {
+        if (hour > newestHour) {
+            windowTotal = totalAt(hour);
+            uint32_t expired = min(hour - newestHour, windowHours);
+            for (uint32_t h = hour - expired + 1; h <= hour; ++h) {
+                buckets[h % windowHours] = 0;
+            }
+            newestHour = hour;
+        }
+        // A clock that stepped back still counts against the newest hour
+        buckets[newestHour % windowHours] += quantity;
+        windowTotal += quantity;
+        rate = rateFor(windowTotal, newestHour);
+    }
+
+    double dailyRate(uint32_t hour) const {
+        return hour <= newestHour ? rate : rateFor(totalAt(hour), hour);
+    }
+
+    uint32_t consumedIn(uint32_t hour) const {
+        if (hour > newestHour || newestHour - hour >= windowHours) return 0;
+        return buckets[hour % windowHours];
+    }
+};
+
+struct StockForecast {
+    string_view itemName;
+    int quantity;
+    double dailyRate;
+    double daysLeft;   // infinity when nothing has been used this week
+};
+
+class Inventory {
+private:
+    int stock[formularySize];
+    unordered_map<string, int> overflow;
+    VersionChain<int> stockHistory[formularySize];
+    unordered_map<string, VersionChain<int>> overflowHistory;
+    ConsumptionSeries consumption[formularySize];
+    unordered_map<string, ConsumptionSeries> overflowConsumption;
+
+    void recordStock(const string& itemName, int quantity, uint32_t now) {
+        int slot = formularySlot(itemName);
+        VersionChain<int>& history = slot >= 0 ? stockHistory[slot] : overflowHistory[itemName];
+        history.record(now, quantity);
+    }
+
+    int* find(const string& itemName) {
+        int slot = formularySlot(itemName);
+        if (slot >= 0) return &stock[slot];
+        auto it = overflow.find(itemName);
+        return it == overflow.end() ? nullptr : &it->second;
+    }
+
+    static void requirePositive(int quantity) {
+        if (quantity < 1) throw InvalidInputException("Quantity must be positive.");
+    }
+
+    const ConsumptionSeries* seriesFor(string_view itemName) const {
+        int slot = formularySlot(itemName);
+        if (slot >= 0) return &consumption[slot];
+        auto it = overflowConsumption.find(string(itemName));
+        return it == overflowConsumption.end() ? nullptr : &it->second;
+    }
+
+public:
+    Inventory() {
+        uint32_t now = currentMinutes();
+        for (size_t i = 0; i < formularySize; ++i) {
+            stock[i] = formulary[i].initialStock;
+            stockHistory[i].record(now, stock[i]);
+        }
+    }
+
+    // With a segment attached the change is made there, and the local count
+    // takes the level it leaves, so other processes' changes are kept
+    void addItem(const string& itemName, int quantity) {
+        requirePositive(quantity);
+        int slot = formularySlot(itemName);
+        int& available = slot >= 0 ? stock[slot] : overflow[itemName];
+        int64_t level;
+        if (sharedStockAdd(itemName, quantity, level)) {
+            available = static_cast<int>(level);
+        } else {
+            available += quantity;
+        }
+        recordStock(itemName, available, currentMinutes());
+    }
+
+    void removeItem(const string& itemName, int quantity) {
+        requirePositive(quantity);
+        int64_t level;
+        bool shared = sharedStockRemove(itemName, quantity, level);
+        int* available = find(itemName);
+        if (shared && !available) {
+            int slot = formularySlot(itemName);
+            available = slot >= 0 ? &stock[slot] : &overflow[itemName];
+        }
+        if (!shared && (!available || *available < quantity)) {
+            throw InsufficientInventoryException("Insufficient quantity of " + itemName + " in inventory.");
+        }
+        *available = shared ? static_cast<int>(level) : *available - quantity;
+        uint32_t now = currentMinutes();
+        recordStock(itemName, *available, now);
+        int slot = formularySlot(itemName);
+        ConsumptionSeries& series = slot >= 0 ? consumption[slot] : overflowConsumption[itemName];
+        series.record(now / 60, static_cast<uint32_t>(quantity));
+        logStockRemoved(itemName, quantity, *available);
+    }
+
+    int quantityOf(const string& itemName) const {
+        int64_t level;
+        if (sharedStockLevel(itemName, level)) return static_cast<int>(level);
+        int slot = formularySlot(itemName);
+        if (slot >= 0) return stock[slot];
+        auto it = overflow.find(itemName);
+        return it == overflow.end() ? 0 : it->second;
+    }
+
+    // Stock of an item as it stood at the given minute
+    int quantityAsOf(const string& itemName, uint32_t minutes) const {
+        const int* quantity = nullptr;
+        int slot = formularySlot(itemName);
+        if (slot >= 0) {
+            quantity = stockHistory[slot].asOf(minutes);
+        } else {
+            auto it = overflowHistory.find(itemName);
+            if (it != overflowHistory.end()) quantity = it->second.asOf(minutes);
+        }
+        return quantity ? *quantity : 0;
+    }
+
+    // Visits formulary items in catalogue order, then overflow items by name.
+    // With a segment attached the shared levels are visited instead.
+    template <typename Visitor>
+    void forEachItem(Visitor visit) const {
+        vector<pair<string, int64_t>> levels;
+        if (sharedStockLevels(levels)) {
+            for (const auto& item : levels) {
+                visit(string_view(item.first), static_cast<int>(item.second));
+            }
+            return;
+        }
+        for (size_t i = 0; i < formularySize; ++i) {
+            visit(formulary[i].name, stock[i]);
+        }
+        vector<const pair<const string, int>*> extra;
+        extra.reserve(overflow.size());
+        for (const auto& item : overflow) extra.push_back(&item);
+        sort(extra.begin(), extra.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+        for (const auto* item : extra) {
+            visit(string_view(item->first), item->second);
+        }
+    }
+
+    // Units used per hour over the last hours hours, oldest first
+    vector<uint32_t> recentConsumption(const string& itemName, uint32_t hours) const {
+        vector<uint32_t> used(hours, 0);
+        const ConsumptionSeries* series = seriesFor(itemName);
+        uint32_t now = currentMinutes() / 60;
+        for (uint32_t i = 0; series && i < hours && i <= now; ++i) {
+            used[hours - 1 - i] = series->consumedIn(now - i);
+        }
+        return used;
+    }
+
+    // Weekly moving-average usage and days until stockout for every item
+    vector<StockForecast> forecast() const {
+        vector<StockForecast> forecasts;
+        uint32_t hour = currentMinutes() / 60;
+        forEachItem([&](string_view itemName, int quantity) {
+            const ConsumptionSeries* series = seriesFor(itemName);
+            double rate = series ? series->dailyRate(hour) : 0.0;
+            double daysLeft = rate > 0 ? quantity / rate : numeric_limits<double>::infinity();
+            forecasts.push_back({ itemName, quantity, rate, daysLeft });
+        });
+        return forecasts;
+    }
+
+    void display() const {
+        cout << "Inventory Records:" << endl;
+        forEachItem([](string_view itemName, int quantity) {
+            cout << itemName << ": " << quantity << " in quantity" << endl;
+        });
+    }
+};
+
+void cancelAppointment(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, PatientHistory& history) {
+    string patientName, dateTime;
+    cout << "Enter patient name for the appointment: ";
+    cin >> patientName;
+    cout << "Enter appointment date and time (YYYY-MM-DD HH:MM): ";
+    cin.ignore();
+    getline(cin, dateTime);
+
+    if (appointments.cancel(patientName, dateTime)) {
+        applyRescheduleNotices(patients, history, appointments, { { patientName, dateTime, "" } });
+        cout << "Appointment cancelled." << endl;
+    } else {
+        cout << "No appointment found for " << patientName << " at " << dateTime << "." << endl;
+    }
+}
+
+class Staff {
+protected:
+    string name;
+    double salary;
+
+public:
+    Staff(const string& n, double s) : name(n), salary(s) {}
+    virtual void displayEarnings() const = 0;
+    virtual void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const = 0;
+    virtual void displayInventory(const Inventory& inventory) const = 0;
+    virtual void manageAppointments(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, PatientHistory&, const vector<unique_ptr<Doctor>>& doctors) const {} // Default implementation for those who don't manage appointments
+    virtual void manageInventorySystem(Inventory& inventory) const {} // Default implementation
+    virtual ~Staff() {}
+
+    const string& getName() const {
+        return name;
+    }
+
+    double getSalary() const {
+        return salary;
+    }
+};
+
+class Doctor : public Staff {
+public:
+    Doctor(const string& n) : Staff(n, 150000.0) {}
+
+    void displayEarnings() const override {
+        cout << "Doctor " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    }
+
+    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
+        cout << "Doctor " << name << ", here are the patient details:" << endl;
+        for (const auto& patient : patients) {
+            patientViews.display(*patient);
+            cout << endl;
+        }
+    }
+
+    void displayInventory(const Inventory& inventory) const override {
+        inventory.display();
+    }
+};
+
+class Nurse : public Staff {
+public:
+    Nurse(const string& n) : Staff(n, 75000.0) {}
+
+    void displayEarnings() const override {
+        cout << "Nurse " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    }
+
+    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
+        cout << "Nurse " << name << ", here are the patient details:" << endl;
+        for (const auto& patient : patients) {
+            patientViews.display(*patient);
+            cout << endl;
+        }
+    }
+
+    void displayInventory(const Inventory& inventory) const override {
+        inventory.display();
+    }
+};
+
+class Receptionist : public Staff {
+public:
+    Receptionist(const string& n) : Staff(n, 60000.0) {}
+
+    void displayEarnings() const override {
+        cout << "Receptionist " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    }
+
+    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
+        cout << "Receptionist " << name << ", here are the patient details:" << endl;
+        for (const auto& patient : patients) {
+            patientViews.display(*patient);
+            cout << endl;
+        }
+    }
+
+    void displayInventory(const Inventory& inventory) const override {
+        cout << "Receptionists do not typically view inventory." << endl;
+    }
+
+    void manageAppointments(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, PatientHistory& history, const vector<unique_ptr<Doctor>>& doctors) const override {
+        cout << "--- Appointment Management ---" << endl;
+        int choice = -1;
+        do {
+            cout << "\n1. Add New Appointment" << endl;
+            cout << "2. Display All Appointments" << endl;
+            cout << "3. Cancel Appointment" << endl;
+            cout << "0. Back to Main Menu" << endl;
+            cout << "Enter your choice: ";
+            try {
+                choice = getValidIntegerInput("");
+                switch (choice) {
+                    case 1: {
+                        string patientName, doctorName, dateTime;
+
+                        cout << "Enter patient name for the appointment: ";
+                        cin >> patientName;
+
+                        auto patientIt = find_if(patients.begin(), patients.end(),
+                                             [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
+                        if (patientIt == patients.end()) {
+                            throw PatientNotFoundException("Patient not found!");
+                        }
+
+                        cout << "Enter doctor's name for the appointment: ";
+                        cin.ignore();
+                        getline(cin, doctorName);
+                        // Ideally, you'd validate if the doctor exists here
+
+                        cout << "Enter appointment date and time (e.g.,YYYY-MM-DD HH:MM): ";
+                        getline(cin, dateTime);
+                        if (!isValidDateTime(dateTime)) {
+                            throw InvalidInputException("Invalid date and time. Use YYYY-MM-DD HH:MM.");
+                        }
+
+                        appointments.add(patientName, dateTime, doctorName);
+                        cout << "New appointment scheduled for " << patientName << " with " << doctorName << " on " << dateTime << endl;
+                        break;
+                    }
+                    case 2: {
+                        cout << "--- All Scheduled Appointments ---" << endl;
+                        if (appointments.all().empty()) {
+                            cout << "No appointments scheduled." << endl;
+                        } else {
+                            for (const auto& appointment : appointments.all()) {
+                                displayDetails(*appointment);
+                                cout << "------------------------------" << endl;
+                            }
+                        }
+                        break;
+                    }
+                    case 3:
+                        cancelAppointment(appointments, patients, history);
+                        break;
+                    case 0:
+                        cout << "Returning to main menu." << endl;
+                        break;
+                    default:
+                        cout << "Invalid choice!" << endl;
+                }
+            } catch (const InvalidInputException& e) {
+                cerr << "Error: " << e.what() << endl;
+                if (cin.eof()) break;
+            } catch (const PatientNotFoundException& e) {
+                cerr << "Error: " << e.what() << endl;
+            }
+        } while (choice != 0);
+    }
+};
+
+class Administrator : public Staff {
+public:
+    Administrator(const string& n) : Staff(n, 90000.0) {}
+
+    void displayEarnings() const override {
+        cout << "Administrator " << name << " Earnings: $" << salary / 12.0 << " salary due at end of month" << endl;
+    }
+
+    void displayPatientDetails(const vector<unique_ptr<Patient>>& patients) const override {
+        cout << "Administrator " << name << ", here are the patient details:" << endl;
+        for (const auto& patient : patients) {
+            patientViews.display(*patient);
+            cout << endl;
+        }
+    }
+
+    void displayInventory(const Inventory& inventory) const override {
+        inventory.display();
+    }
+
+    void manageInventorySystem(Inventory& inventory) const override {
+        manageInventorySystem(inventory); // Reusing the existing inventory management function
+    }
+};
+
+void handlePatient(const vector<unique_ptr<Patient>>& patients) {
+    cout << "Welcome, Patient! You can check your details." << endl;
+    string inputName;
+    cout << "Enter your name: ";
+    cin >> inputName;
+    auto it = find_if(patients.begin(), patients.end(),
+                        [&](const unique_ptr<Patient>& p){ return p->matchesName(inputName); });
+
+    if (it != patients.end()) {
+        cout << "Patient details found:" << endl;
+        patientViews.display(**it);
+        int choice;
+        cout << "What would you like to know?" << endl;
+        cout << "1. Dues" << endl;
+        cout << "2. Appointments" << endl;
+        cout << "Enter your choice (1-2): ";
+        try {
+            choice = getValidIntegerInput("");
+            switch (choice) {
+                case 1:
+                    (*it)->displayDues();
+                    break;
+                case 2:
+                    (*it)->displayAppointments();
+                    break;
+                default:
+                    cout << "Invalid choice!" << endl;
+            }
+        } catch (const InvalidInputException& e) {
+            cerr << "Error: " << e.what() << endl;
+        }
+    } else {
+        cout << "No records found for " << inputName << "!" << endl;
+    }
+}
+
+void handleNurse(const vector<unique_ptr<Patient>>& patients, const Inventory& inventory) {
+    cout << "Welcome, Nurse!" << endl;
+    string nurseName;
+    cout << "Enter Nurse's name: ";
+    cin >> nurseName;
+    Nurse nurse(nurseName);
+
+    int option;
+    cout << "What would you like to see?" << endl;
+    cout << "1. Patient Details" << endl;
+    cout << "2. Inventory Records" << endl;
+    cout << "3. Earnings" << endl;
+    cout << "Enter your choice (1-3): ";
+    try {
+        option = getValidIntegerInput("");
+        switch (option) {
+            case 1:
+                nurse.displayPatientDetails(patients);
+                break;
+            case 2:
+                nurse.displayInventory(inventory);
+                break;
+            case 3:
+                nurse.displayEarnings();
+                break;
+            default:
+                cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void handleDoctor(const vector<unique_ptr<Patient>>& patients, const Inventory& inventory) {
+    cout << "Welcome, Doctor!" << endl;
+    string doctorName;
+    cout << "Enter Doctor's name: ";
+    cin >> doctorName;
+    Doctor doctor(doctorName);
+
+    int option;
+    cout << "What would you like to see?" << endl;
+    cout << "1. Patient Details" << endl;
+    cout << "2. Inventory Records" << endl;
+    cout << "3. Earnings" << endl;
+    cout << "Enter your choice (1-3): ";
+    try {
+        option = getValidIntegerInput("");
+        switch (option) {
+            case 1:
+                doctor.displayPatientDetails(patients);
+                break;
+            case 2:
+                doctor.displayInventory(inventory);
+                break;
+            case 3:
+                doctor.displayEarnings();
+                break;
+            default:
+                cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void handleReceptionist(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, PatientHistory& history, const vector<unique_ptr<Doctor>>& doctors) {
+    cout << "Welcome, Receptionist!" << endl;
+    string receptionistName;
+    cout << "Enter Receptionist's name: ";
+    cin >> receptionistName;
+    Receptionist receptionist(receptionistName);
+
+    int option;
+    cout << "What would you like to do?" << endl;
+    cout << "1. Manage Appointments" << endl;
+    cout << "2. View Patient Details" << endl;
+    cout << "3. View Earnings" << endl;
+    cout << "Enter your choice (1-3): ";
+    try {
+        option = getValidIntegerInput("");
+        switch (option) {
+            case 1:
+                receptionist.manageAppointments(appointments, patients, history, doctors);
+                break;
+            case 2: {
+                string patientName;
+                cout << "Enter patient name to view details: ";
+                cin >> patientName;
+                auto it = find_if(patients.begin(), patients.end(),
+                                     [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
+                if (it != patients.end()) {
+                    displayDetails(**it);
+                } else {
+                    cout << "Patient not found!" << endl;
+                }
+                break;
+            }
+            case 3:
+                receptionist.displayEarnings();
+                break;
+            default:
+                cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void handleAdministrator(Inventory& inventory, const vector<unique_ptr<Patient>>& patients) {
+    cout << "Welcome, Administrator!" << endl;
+    string adminName;
+    cout << "Enter Administrator's name: ";
+    cin >> adminName;
+    Administrator administrator(adminName);
+
+    int choice;
+    cout << "What would you like to do?" << endl;
+    cout << "1. Manage Inventory" << endl;
+    cout << "2. View Patient Details" << endl;
+    cout << "3. View Earnings" << endl;
+    cout << "Enter your choice (1-3): ";
+    try {
+        choice = getValidIntegerInput("");
+        switch (choice) {
+            case 1:
+                administrator.manageInventorySystem(inventory);
+                break;
+            case 2:
+                 administrator.displayPatientDetails(patients);
+                 break;
+            case 3:
+                administrator.displayEarnings();
+                break;
+            default:
+                cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void addNewPatient(vector<unique_ptr<Patient>>& patients, PhoneIndex& phoneIndex, PatientHistory& history) {
+    string name, phoneNumber, appointmentDate = "";
+    int previousAdmittances = 0;
+    double paymentDue = 0.0;
+    bool hasAppointment = false;
+
+    cout << "Enter patient name: ";
+    cin >> name;
+
+    try {
+        previousAdmittances = getValidIntegerInput("Enter previous admittances: ");
+        paymentDue = getValidDoubleInput("Enter payment due: ");
+        hasAppointment = getYesNoInput("Does the patient have an appointment?");
+        if (hasAppointment) {
+            cout << "Enter appointment date and time (YYYY-MM-DD HH:MM): ";
+            cin.ignore();
+            getline(cin, appointmentDate);
+        }
+        cout << "Enter phone number: ";
+        cin >> phoneNumber;
+
+        registerPatient(patients, phoneIndex, history, make_unique<Patient>(name, previousAdmittances, paymentDue, hasAppointment, appointmentDate, phoneNumber));
+        logPatientAdded(*patients.back());
+        cout << "New patient added successfully!" << endl;
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void addNewAppointment(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, const vector<unique_ptr<Doctor>>& doctors) {
+    string patientName, doctorName, dateTime;
+
+    cout << "Enter patient name for the appointment: ";
+    cin >> patientName;
+
+    auto patientIt = find_if(patients.begin(), patients.end(),
+                                 [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
+    if (patientIt == patients.end()) {
+        cout << "Patient not found!" << endl;
+        return;
+    }
+
+    cout << "Enter doctor's name for the appointment: ";
+    cin.ignore();
+    getline(cin, doctorName);
+
+    cout << "Enter appointment date and time (e.g.,YYYY-MM-DD HH:MM): ";
+    getline(cin, dateTime);
+    if (!isValidDateTime(dateTime)) {
+        cout << "Invalid date and time. Use YYYY-MM-DD HH:MM." << endl;
+        return;
+    }
+
+    appointments.add(patientName, dateTime, doctorName);
+    cout << "New appointment scheduled successfully!" << endl;
+}
+
+void displayAllAppointments(const AppointmentBook& appointments) {
+    cout << "--- All Scheduled Appointments ---" << endl;
+    if (appointments.all().empty()) {
+        cout << "No appointments scheduled." << endl;
+        return;
+    }
+    for (const auto& appointment : appointments.all()) {
+        displayDetails(*appointment);
+        cout << "------------------------------" << endl;
+    }
+}
+
+void displayDoctorAppointmentsToday(const AppointmentBook& appointments) {
+    string doctorName;
+    cout << "Enter doctor's name: ";
+    cin.ignore();
+    getline(cin, doctorName);
+
+    string today = todaysDate();
+    cout << "--- Appointments for " << doctorName << " on " << today << " ---" << endl;
+    appointments.displayForDoctor(doctorName, today, today);
+}
+
+void displayPatientAppointmentHistory(const AppointmentBook& appointments) {
+    string patientName;
+    cout << "Enter patient name: ";
+    cin >> patientName;
+
+    cout << "--- Appointment History for " << patientName << " ---" << endl;
+    appointments.displayForPatient(patientName);
+}
+
+void rescheduleDoctorAppointments(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients, PatientHistory& history) {
+    string doctorName, from, to;
+    cout << "Enter doctor's name: ";
+    cin.ignore();
+    getline(cin, doctorName);
+    cout << "Enter start (YYYY-MM-DD or YYYY-MM-DD HH:MM): ";
+    getline(cin, from);
+    cout << "Enter end (YYYY-MM-DD or YYYY-MM-DD HH:MM): ";
+    getline(cin, to);
+
+    try {
+        int action = getValidIntegerInput("1. Cancel all\n2. Shift all by days\nEnter your choice: ");
+        if (action != 1 && action != 2) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        long shiftMinutes = action == 2 ? getValidIntegerInput("Shift by how many days (negative moves earlier): ") * 1440L : 0;
+
+        auto start = chrono::steady_clock::now();
+        vector<RescheduleNotice> notices = action == 1
+            ? appointments.cancelForDoctor(doctorName, from, to)
+            : appointments.shiftForDoctor(doctorName, from, to, shiftMinutes);
+        applyRescheduleNotices(patients, history, appointments, notices);
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        cout << notices.size() << " appointments " << (action == 1 ? "cancelled" : "moved") << " in " << milliseconds << " ms" << endl;
+        if (!notices.empty()) cout << "--- Patients to Notify ---" << endl;
+        for (const auto& notice : notices) {
+            cout << notice.patientName << ": " << notice.oldDateTime;
+            if (notice.newDateTime.empty()) cout << " cancelled" << endl;
+            else cout << " moved to " << notice.newDateTime << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void displayAppointmentsBetween(const AppointmentBook& appointments) {
+    string from, to;
+    cout << "Enter start (YYYY-MM-DD or YYYY-MM-DD HH:MM): ";
+    cin.ignore();
+    getline(cin, from);
+    cout << "Enter end (YYYY-MM-DD or YYYY-MM-DD HH:MM): ";
+    getline(cin, to);
+
+    cout << "--- Appointments from " << from << " to " << to << " ---" << endl;
+    appointments.displayBetween(from, to);
+}
+
+void searchPatientByName(const vector<unique_ptr<Patient>>& patients) {
+    string searchName;
+    cout << "Enter the name of the patient to search: ";
+    cin >> searchName;
+
+    auto it = find_if(patients.begin(), patients.end(),
+                        [&](const unique_ptr<Patient>& p){ return p->matchesName(searchName); });
+
+    if (it != patients.end()) {
+        cout << "Patient found:" << endl;
+        patientViews.display(**it);
+        return;
+    }
+    uint32_t handle;
+    try {
+        if (loadedPatients && loadedPatients->findByName(searchName, handle)) {
+            cout << "Patient found in the loaded segments:" << endl;
+            displayDetails(loadedPatients->materialize(handle));
+            return;
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+    size_t stored = 0;
+    if (openRegistry) {
+        try {
+            stored = openRegistry->findByName(searchName, [](uint32_t id, const Patient& patient) {
+                cout << "Patient found in the disk registry (ID " << id << "):" << endl;
+                displayDetails(patient);
+            });
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+        }
+    }
+    if (stored == 0) cout << "Patient with name '" << searchName << "' not found." << endl;
+}
+
+void lookupCaller(const vector<unique_ptr<Patient>>& patients, const PhoneIndex& phoneIndex) {
+    string phone;
+    cout << "Enter caller's phone number: ";
+    cin >> phone;
+
+    try {
+        size_t handle;
+        if (phoneIndex.find(packPhoneNumber(phone), handle)) {
+            cout << "Caller identified:" << endl;
+            displayDetails(*patients[handle]);
+        } else {
+            cout << "No patient registered with phone number " << phone << "." << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void displayMemoryReport(const vector<unique_ptr<Patient>>& patients, const PhoneIndex& phoneIndex) {
+    size_t count = patients.size();
+    size_t recordBytes = count * sizeof(Patient);
+    size_t overflowBytes = 0;
+    // Each record is its own heap block: malloc rounds the size up and puts a
+    // size word in front, which the record sizes alone do not show
+    size_t mallocBytes = 0;
+    for (const auto& patient : patients) {
+        overflowBytes += patient->heapBytes();
+        mallocBytes += malloc_usable_size(patient.get()) + sizeof(size_t) - sizeof(Patient);
+    }
+    size_t handleBytes = patients.capacity() * sizeof(unique_ptr<Patient>);
+    size_t indexBytes = phoneIndex.memoryBytes();
+    size_t totalBytes = recordBytes + mallocBytes + overflowBytes + handleBytes + indexBytes;
+
+    cout << "--- Patient Memory Report ---" << endl;
+    cout << "Patients: " << count << endl;
+    cout << "Record size: " << sizeof(Patient) << " bytes" << endl;
+    cout << "Records: " << recordBytes << " bytes" << endl;
+    cout << "Allocator overhead: " << mallocBytes << " bytes";
+    if (count > 0) cout << " (" << static_cast<double>(mallocBytes) / count << " per record)";
+    cout << endl;
+    cout << "Long-name overflow: " << overflowBytes << " bytes" << endl;
+    cout << "Record handles: " << handleBytes << " bytes" << endl;
+    cout << "Phone index: " << indexBytes << " bytes" << endl;
+    cout << "Total: " << totalBytes << " bytes" << endl;
+    if (count > 0) {
+        cout << "Hot data per patient: " << static_cast<double>(recordBytes + overflowBytes) / count << " bytes" << endl;
+        cout << "Total per patient: " << static_cast<double>(totalBytes) / count << " bytes" << endl;
+    }
+}
+
+enum class ExportFormat { Csv, JsonLines };
+
+// Streams records into a ring of fixed chunks and hands all of them to the
+// kernel in one writev() once they fill, so memory stays constant however
+// many records are exported.
+class ExportWriter {
+private:
+    static constexpr size_t chunkSize = 1 << 20;
+    static constexpr int chunkCount = 4;
+
+    int fd;
+    ExportFormat format;
+    vector<char> buffer;
+    int chunk;
+    size_t used;
+    bool firstField;
+    size_t records;
+    size_t recordsWritten;   // records whose bytes have all gone to write()
+    size_t bytesWritten;
+
+    void writeChunks(int fullChunks, size_t tailBytes) {
+        iovec parts[chunkCount];
+        int partCount = 0;
+        for (int i = 0; i < fullChunks; ++i) {
+            parts[partCount++] = { buffer.data() + i * chunkSize, chunkSize };
+        }
+        if (tailBytes > 0) {
+            parts[partCount++] = { buffer.data() + fullChunks * chunkSize, tailBytes };
+        }
+        int first = 0;
+        while (first < partCount) {
+            ssize_t written = writev(fd, parts + first, partCount - first);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw runtime_error(string("Export write failed: ") + strerror(errno));
+            }
+            bytesWritten += written;
+            while (first < partCount && static_cast<size_t>(written) >= parts[first].iov_len) {
+                written -= parts[first++].iov_len;
+            }
+            if (first < partCount) {
+                parts[first].iov_base = static_cast<char*>(parts[first].iov_base) + written;
+                parts[first].iov_len -= written;
+            }
+        }
+        chunk = 0;
+        used = 0;
+        recordsWritten = records;
+    }
+
+    void put(const char* data, size_t size) {
+        while (size > 0) {
+            size_t room = chunkSize - used;
+            size_t take = size < room ? size : room;
+            memcpy(buffer.data() + chunk * chunkSize + used, data, take);
+            used += take;
+            data += take;
+            size -= take;
+            if (used == chunkSize) {
+                if (chunk + 1 == chunkCount) {
+                    writeChunks(chunkCount, 0);
+                } else {
+                    ++chunk;
+                    used = 0;
+                }
+            }
+        }
+    }
+
+    void put(char c) {
+        put(&c, 1);
+    }
+
+    void beginField(const char* key) {
+        if (!firstField) put(',');
+        firstField = false;
+        if (format == ExportFormat::JsonLines) {
+            put('"');
+            put(key, strlen(key));
+            put("\":", 2);
+        }
+    }
+
+public:
+    ExportWriter(const string& path, ExportFormat fmt, bool append)
+        : format(fmt), buffer(chunkSize * chunkCount), chunk(0), used(0), firstField(true), records(0), recordsWritten(0), bytesWritten(0) {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+        if (fd < 0) {
+            throw runtime_error("Cannot open " + path + ": " + strerror(errno));
+        }
+    }
+
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    ~ExportWriter() {
+        close(fd);
+    }
+
+    void header(initializer_list<const char*> columns) {
+        if (format != ExportFormat::Csv) return;
+        for (const char* column : columns) {
+            if (!firstField) put(',');
+            firstField = false;
+            put(column, strlen(column));
+        }
+        put('\n');
+        firstField = true;
+    }
+
+    void beginRecord() {
+        if (format == ExportFormat::JsonLines) put('{');
+        firstField = true;
+    }
+
+    void endRecord() {
+        if (format == ExportFormat::JsonLines) put('}');
+        put('\n');
+        ++records;
+    }
+
+    void field(const char* key, const char* text, size_t size) {
+        beginField(key);
+        bool csv = format == ExportFormat::Csv;
+        put('"');
+        const char* run = text;
+        for (const char* c = text; c != text + size; ++c) {
+            bool escape = csv ? *c == '"' : (*c == '"' || *c == '\\' || static_cast<unsigned char>(*c) < 0x20);
+            if (!escape) continue;
+            put(run, c - run);
+            if (csv) {
+                put("\"\"", 2);
+            } else if (static_cast<unsigned char>(*c) < 0x20) {
+                char code[7];
+                snprintf(code, sizeof(code), "\\u%04x", *c);
+                put(code, 6);
+            } else {
+                put('\\');
+                put(*c);
+            }
+            run = c + 1;
+        }
+        put(run, text + size - run);
+        put('"');
+    }
+
+    void field(const char* key, const string& text) {
+        field(key, text.data(), text.size());
+    }
+
+    void field(const char* key, long long value) {
+        beginField(key);
+        char digits[24];
+        put(digits, to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+    }
+
+    // JSON has no NaN or infinity; they are written as null, or left empty in CSV
+    void field(const char* key, double value) {
+        beginField(key);
+        if (!isfinite(value)) {
+            if (format == ExportFormat::JsonLines) put("null", 4);
+            return;
+        }
+        char digits[32];
+        put(digits, to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+    }
+
+    void field(const char* key, bool value) {
+        beginField(key);
+        if (format == ExportFormat::Csv) put(value ? '1' : '0');
+        else if (value) put("true", 4);
+        else put("false", 5);
+    }
+
+    void flush() {
+        writeChunks(chunk, used);
+    }
+
+    size_t recordCount() const {
+        return records;
+    }
+
+    size_t writtenRecordCount() const {
+        return recordsWritten;
+    }
+
+    size_t writtenByteCount() const {
+        return bytesWritten;
+    }
+
+    size_t byteCount() const {
+        return bytesWritten + chunk * chunkSize + used;
+    }
+};
+
+// Counts only what has reached write(), so the figure is safe to resume from;
+// records still in the ring are not reported yet
+void reportExportProgress(const ExportWriter& writer, size_t offset, size_t total) {
+    cout << "Exported " << offset + writer.writtenRecordCount() << " of " << total << " records ("
+         << writer.writtenByteCount() / (1024 * 1024) << " MB written)" << endl;
+}
+
+const size_t exportProgressInterval = 1 << 20;
+
+// Each export starts at record 'offset', so an interrupted run can be resumed
+// by appending from the last reported count.
+void exportPatients(ExportWriter& writer, const vector<unique_ptr<Patient>>& patients, size_t offset) {
+    if (offset == 0) {
+        writer.header({ "name", "previous_admittances", "payment_due", "has_appointment", "appointment", "phone" });
+    }
+    for (size_t i = offset; i < patients.size(); ++i) {
+        const Patient& patient = *patients[i];
+        const CompactString& name = patient.getCompactName();
+        char appointment[17] = "";
+        if (patient.hasAppointment()) formatDateTime(patient.getAppointmentMinutes(), appointment);
+
+        writer.beginRecord();
+        writer.field("name", name.data(), name.size());
+        writer.field("previous_admittances", static_cast<long long>(patient.getPreviousAdmittances()));
+        writer.field("payment_due", patient.getPaymentDue());
+        writer.field("has_appointment", patient.hasAppointment());
+        writer.field("appointment", appointment, strlen(appointment));
+        writer.field("phone", formatPhoneNumber(patient.getPhoneNumber()));
+        writer.endRecord();
+
+        if ((i + 1) % exportProgressInterval == 0) reportExportProgress(writer, offset, patients.size());
+    }
+}
+
+void exportAppointments(ExportWriter& writer, const AppointmentBook& appointments, size_t offset) {
+    const auto& all = appointments.all();
+    if (offset == 0) {
+        writer.header({ "patient", "date_time", "doctor" });
+    }
+    for (size_t i = offset; i < all.size(); ++i) {
+        writer.beginRecord();
+        writer.field("patient", all[i]->getPatientName());
+        writer.field("date_time", all[i]->getDateAndTime());
+        writer.field("doctor", all[i]->getDoctorName());
+        writer.endRecord();
+
+        if ((i + 1) % exportProgressInterval == 0) reportExportProgress(writer, offset, all.size());
+    }
+}
+
+void exportInventory(ExportWriter& writer, const Inventory& inventory, size_t offset) {
+    if (offset == 0) {
+        writer.header({ "item", "quantity" });
+    }
+    size_t i = 0;
+    inventory.forEachItem([&](string_view itemName, int quantity) {
+        if (i++ < offset) return;
+        writer.beginRecord();
+        writer.field("item", itemName.data(), itemName.size());
+        writer.field("quantity", static_cast<long long>(quantity));
+        writer.endRecord();
+    });
+}
+
+void exportData(const vector<unique_ptr<Patient>>& patients, const AppointmentBook& appointments, const Inventory& inventory) {
+    cout << "\n--- Export Data ---" << endl;
+    cout << "1. Patients" << endl;
+    cout << "2. Appointments" << endl;
+    cout << "3. Inventory" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int dataset = getValidIntegerInput("");
+        if (dataset < 1 || dataset > 3) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        int formatChoice = getValidIntegerInput("Format (1. CSV, 2. JSON lines): ");
+        if (formatChoice != 1 && formatChoice != 2) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        string path;
+        cout << "Enter output file path: ";
+        cin >> path;
+        int offset = getValidIntegerInput("Resume from record (0 to start over): ");
+        if (offset < 0) {
+            throw InvalidInputException("Record offset cannot be negative.");
+        }
+
+        auto start = chrono::steady_clock::now();
+        ExportWriter writer(path, formatChoice == 1 ? ExportFormat::Csv : ExportFormat::JsonLines, offset > 0);
+        switch (dataset) {
+            case 1:
+                exportPatients(writer, patients, offset);
+                break;
+            case 2:
+                exportAppointments(writer, appointments, offset);
+                break;
+            case 3:
+                exportInventory(writer, inventory, offset);
+                break;
+        }
+        writer.flush();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "Exported " << writer.recordCount() << " records (" << writer.byteCount() << " bytes) to " << path;
+        if (seconds > 0) cout << " at " << writer.byteCount() / seconds / (1024 * 1024) << " MB/s";
+        cout << endl;
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void updatePaymentDue(const vector<unique_ptr<Patient>>& patients, PatientHistory& history) {
+    string patientName;
+    cout << "Enter patient name: ";
+    cin >> patientName;
+
+    auto it = find_if(patients.begin(), patients.end(),
+                        [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
+    if (it == patients.end()) {
+        cout << "Patient not found!" << endl;
+        return;
+    }
+
+    try {
+        double payment = getValidDoubleInput("Enter new payment due: ");
+        patientViews.forget((*it)->getRevision());
+        (*it)->setPaymentDue(payment);
+        history.record(it - patients.begin(), **it);
+        sharePaymentDue(**it);
+        cout << "Payment due for " << patientName << " updated to " << payment << endl;
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+uint32_t readPointInTime() {
+    string when;
+    cout << "As of (YYYY-MM-DD HH:MM, UTC): ";
+    cin.ignore();
+    getline(cin, when);
+    return packDateTime(when);
+}
+
+void displayStockAsOf(const Inventory& inventory) {
+    try {
+        uint32_t minutes = readPointInTime();
+        string itemName;
+        cout << "Enter item name (or 'all'): ";
+        getline(cin, itemName);
+
+        cout << "--- Inventory as of " << formatDateTime(minutes) << " ---" << endl;
+        if (itemName == "all") {
+            inventory.forEachItem([&](string_view name, int) {
+                string item(name);
+                cout << item << ": " << inventory.quantityAsOf(item, minutes) << " in quantity" << endl;
+            });
+        } else {
+            cout << itemName << ": " << inventory.quantityAsOf(itemName, minutes) << " in quantity" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void displayPatientAsOf(const vector<unique_ptr<Patient>>& patients, const PatientHistory& history) {
+    try {
+        uint32_t minutes = readPointInTime();
+        string patientName;
+        cout << "Enter patient name: ";
+        cin >> patientName;
+
+        auto it = find_if(patients.begin(), patients.end(),
+                            [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
+        if (it == patients.end()) {
+            cout << "Patient not found!" << endl;
+            return;
+        }
+
+        const PatientSnapshot* snapshot = history.asOf(it - patients.begin(), minutes);
+        if (!snapshot) {
+            cout << patientName << " was not registered as of " << formatDateTime(minutes) << "." << endl;
+            return;
+        }
+        cout << "--- " << patientName << " as of " << formatDateTime(minutes) << " ---" << endl;
+        cout << "Previous Admittances: " << snapshot->previousAdmittances << endl;
+        cout << "Payment Due: " << snapshot->paymentDue << endl;
+        cout << "Appointment Scheduled: " << (snapshot->hasAppointment ? "Yes" : "No") << endl;
+        if (snapshot->hasAppointment) {
+            cout << "Appointment Date: " << formatDateTime(snapshot->appointmentMinutes) << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Blood bags belong to the blood bank; defined with BloodBank
+bool isBloodBagItem(string_view itemName);
+
+void manageInventory(Inventory& inventory) {
+    int choice;
+    cout << "\n--- Inventory Management ---" << endl;
+    cout << "1. Add Item" << endl;
+    cout << "2. Remove Item" << endl;
+    cout << "3. Display Inventory" << endl;
+    cout << "4. Back to Main Menu" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        choice = getValidIntegerInput("");
+        switch (choice) {
+            case 1: {
+                string itemName;
+                int quantity;
+                cout << "Enter item name to add: ";
+                cin.ignore();
+                getline(cin, itemName);
+                if (isBloodBagItem(itemName)) {
+                    cout << "Blood bags are received through the Blood Bank menu." << endl;
+                    break;
+                }
+                quantity = getValidIntegerInput("Enter quantity to add: ");
+                inventory.addItem(itemName, quantity);
+                cout << itemName << " added to inventory." << endl;
+                break;
+            }
+            case 2: {
+                string itemName;
+                int quantity;
+                cout << "Enter item name to remove: ";
+                cin.ignore();
+                getline(cin, itemName);
+                if (isBloodBagItem(itemName)) {
+                    cout << "Blood bags are issued through the Blood Bank menu." << endl;
+                    break;
+                }
+                quantity = getValidIntegerInput("Enter quantity to remove: ");
+                try {
+                    inventory.removeItem(itemName, quantity);
+                    cout << quantity << " of " << itemName << " removed from inventory." << endl;
+                } catch (const InsufficientInventoryException& e) {
+                    cerr << "Error: " << e.what() << endl;
+                }
+                break;
+            }
+            case 3:
+                inventory.display();
+                break;
+            case 4:
+                cout << "Returning to main menu." << endl;
+                break;
+            default:
+                cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+Patient randomPatient(mt19937_64& random) {
+    string name(12, 'a');
+    for (char& c : name) c = static_cast<char>('a' + random() % 26);
+    name[0] = static_cast<char>(toupper(name[0]));
+    string phone = to_string(6000000000ULL + random() % 4000000000ULL);
+    bool appointment = random() % 4 == 0;
+    string date = appointment ? formatDateTime(static_cast<uint32_t>(13000000 + random() % 600000)) : "";
+    return Patient(name, static_cast<int>(random() % 10), static_cast<double>(random() % 50000), appointment, date, phone);
+}
+
+// Columnar archive for historical appointments and patients. Rows are
+// sorted and cut into blocks; each block stores its columns one after
+// another, bit-packed at the narrowest width the block needs. Doctor and
+// patient names in appointments are dictionary ids, appointment times are
+// deltas from the previous row, and patient names are front-coded. The
+// block directory keeps each block's time or name range, so a query only
+// reads and decodes the blocks that can match.
+struct ArchivedAppointment {
+    string patient;
+    uint32_t minutes;
+    string doctor;
+};
+
+struct ArchivedPatient {
+    string name;
+    uint32_t previousAdmittances;
+    double paymentDue;
+    uint64_t phoneNumber;
+    bool hasAppointment;
+    uint32_t appointmentMinutes;
+};
+
+struct ArchiveBlock {
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t rows;
+    uint32_t minMinutes;
+    uint32_t maxMinutes;
+    string firstName;
+    string lastName;
+};
+
+struct ArchiveScanStats {
+    size_t blocksRead = 0;
+    size_t blocksSkipped = 0;
+    size_t rowsDecoded = 0;
+    size_t bytesRead = 0;
+};
+
+constexpr uint64_t archiveMagic = 0x3143524148435241ULL;   // "ARCHARC1"
+constexpr size_t archiveBlockRows = 4096;
+
+int bitsFor(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+class BitWriter {
+private:
+    string& out;
+    uint64_t pending;
+    int pendingBits;
+
+public:
+    explicit BitWriter(string& output) : out(output), pending(0), pendingBits(0) {}
+
+    // Fields wider than 56 bits go in two parts, so pending never overflows
+    void put(uint64_t value, int width) {
+        if (width == 0) return;
+        if (width > 56) {
+            put(value & 0xffffffff, 32);
+            put(value >> 32, width - 32);
+            return;
+        }
+        pending |= value << pendingBits;
+        pendingBits += width;
+        while (pendingBits >= 8) {
+            out.push_back(static_cast<char>(pending & 0xff));
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+
+    void finish() {
+        if (pendingBits > 0) out.push_back(static_cast<char>(pending & 0xff));
+        pending = 0;
+        pendingBits = 0;
+    }
+};
+
+// Reads little-endian bit fields; the buffer must have 8 bytes of slack
+class BitReader {
+private:
+    const unsigned char* data;
+    size_t bit;
+
+public:
+    BitReader(const char* buffer, size_t start) : data(reinterpret_cast<const unsigned char*>(buffer)), bit(start * 8) {}
+
+    uint64_t get(int width) {
+        if (width == 0) return 0;
+        if (width > 56) {
+            uint64_t low = get(32);
+            return low | get(width - 32) << 32;
+        }
+        uint64_t word;
+        memcpy(&word, data + (bit >> 3), sizeof(word));
+        uint64_t value = (word >> (bit & 7)) & ((uint64_t(1) << width) - 1);
+        bit += width;
+        return value;
+    }
+
+    size_t bytePosition() const {
+        return (bit + 7) / 8;
+    }
+};
+
+void putVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t getVarint(const string& in, size_t& position) {
+    uint64_t value = 0;
+    for (int shift = 0; position < in.size(); shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(in[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+    }
+    throw runtime_error("Archive is truncated.");
+}
+
+void putText(string& out, const string& text) {
+    putVarint(out, text.size());
+    out += text;
+}
+
+string getText(const string& in, size_t& position) {
+    size_t length = getVarint(in, position);
+    if (position + length > in.size()) throw runtime_error("Archive is truncated.");
+    string text = in.substr(position, length);
+    position += length;
+    return text;
+}
+
+// Sorted strings as (shared prefix length, suffix)
+void putFrontCoded(string& out, const vector<string>& sorted, size_t first, size_t last) {
+    const string* previous = nullptr;
+    for (size_t i = first; i < last; ++i) {
+        const string& text = sorted[i];
+        size_t shared = 0;
+        if (previous) {
+            size_t limit = min(previous->size(), text.size());
+            while (shared < limit && (*previous)[shared] == text[shared]) ++shared;
+        }
+        putVarint(out, shared);
+        putVarint(out, text.size() - shared);
+        out.append(text, shared, string::npos);
+        previous = &text;
+    }
+}
+
+void getFrontCoded(const string& in, size_t& position, size_t count, vector<string>& out) {
+    string previous;
+    for (size_t i = 0; i < count; ++i) {
+        size_t shared = getVarint(in, position);
+        size_t length = getVarint(in, position);
+        if (shared > previous.size() || position + length > in.size()) throw runtime_error("Archive is corrupt.");
+        previous.resize(shared);
+        previous.append(in, position, length);
+        position += length;
+        out.push_back(previous);
+    }
+}
+
+size_t decimalDigits(uint64_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+// Size of the same rows as exported CSV, the format the archive replaces
+size_t csvBytes(const ArchivedAppointment& row) {
+    return row.patient.size() + 16 + row.doctor.size() + 3;
+}
+
+size_t csvBytes(const ArchivedPatient& row) {
+    char digits[32];
+    size_t dueDigits = to_chars(digits, digits + sizeof(digits), row.paymentDue).ptr - digits;
+    return row.name.size() + decimalDigits(row.previousAdmittances) + dueDigits + 1 + (row.hasAppointment ? 16 : 0) + 10 + 6;
+}
+
+class ColumnArchiveWriter {
+private:
+    string header;
+    string blocks;
+
+    // Sorted distinct values of a column, and each row's index into them
+    static vector<string> dictionaryOf(const vector<ArchivedAppointment>& rows, string ArchivedAppointment::*field, vector<uint32_t>& ids) {
+        // Number values in order of first appearance, then renumber by rank
+        unordered_map<string_view, uint32_t> distinct;
+        vector<string_view> seen;
+        ids.resize(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            auto entry = distinct.try_emplace(rows[i].*field, static_cast<uint32_t>(seen.size()));
+            if (entry.second) seen.push_back(entry.first->first);
+            ids[i] = entry.first->second;
+        }
+
+        vector<uint32_t> byValue(seen.size());
+        for (size_t i = 0; i < byValue.size(); ++i) byValue[i] = static_cast<uint32_t>(i);
+        sort(byValue.begin(), byValue.end(), [&](uint32_t a, uint32_t b) { return seen[a] < seen[b]; });
+        vector<uint32_t> rank(seen.size());
+        vector<string> dictionary;
+        dictionary.reserve(seen.size());
+        for (size_t i = 0; i < byValue.size(); ++i) {
+            rank[byValue[i]] = static_cast<uint32_t>(i);
+            dictionary.emplace_back(seen[byValue[i]]);
+        }
+        for (auto& id : ids) id = rank[id];
+        return dictionary;
+    }
+
+    void putBlock(string& directory, ArchiveBlock block, const string& data) {
+        block.offset = blocks.size();
+        block.bytes = static_cast<uint32_t>(data.size());
+        blocks += data;
+        putVarint(directory, block.offset);
+        putVarint(directory, block.bytes);
+        putVarint(directory, block.rows);
+        putVarint(directory, block.minMinutes);
+        putVarint(directory, block.maxMinutes);
+        putText(directory, block.firstName);
+        putText(directory, block.lastName);
+    }
+
+    void writeAppointments(const vector<ArchivedAppointment>& rows) {
+        // Time order as (minutes, row) pairs, cheaper to sort than the rows
+        vector<uint64_t> order(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) order[i] = static_cast<uint64_t>(rows[i].minutes) << 32 | i;
+        sort(order.begin(), order.end());
+        auto timeOf = [&](size_t i) { return static_cast<uint32_t>(order[i] >> 32); };
+        auto rowOf = [&](size_t i) { return static_cast<uint32_t>(order[i]); };
+
+        vector<uint32_t> doctorIds, patientIds;
+        vector<string> doctors = dictionaryOf(rows, &ArchivedAppointment::doctor, doctorIds);
+        vector<string> patients = dictionaryOf(rows, &ArchivedAppointment::patient, patientIds);
+        putVarint(header, doctors.size());
+        putFrontCoded(header, doctors, 0, doctors.size());
+        putVarint(header, patients.size());
+        putFrontCoded(header, patients, 0, patients.size());
+
+        int doctorWidth = bitsFor(doctors.empty() ? 0 : doctors.size() - 1);
+        int patientWidth = bitsFor(patients.empty() ? 0 : patients.size() - 1);
+        string directory;
+        size_t blockCount = 0;
+        for (size_t first = 0; first < rows.size(); first += archiveBlockRows, ++blockCount) {
+            size_t last = min(rows.size(), first + archiveBlockRows);
+            // Many appointments share a slot, so times are stored as runs:
+            // the delta to the previous run's time and the run length
+            vector<pair<uint32_t, uint32_t>> runs;
+            for (size_t i = first; i < last; ++i) {
+                if (i > first && timeOf(i) == timeOf(i - 1)) {
+                    ++runs.back().second;
+                } else {
+                    runs.emplace_back(i > first ? timeOf(i) - timeOf(i - 1) : 0, 1);
+                }
+            }
+            uint64_t maxDelta = 0, maxRun = 0;
+            for (const auto& run : runs) {
+                maxDelta = max<uint64_t>(maxDelta, run.first);
+                maxRun = max<uint64_t>(maxRun, run.second - 1);
+            }
+            int deltaWidth = bitsFor(maxDelta);
+            int runWidth = bitsFor(maxRun);
+
+            string data;
+            putVarint(data, runs.size());
+            data.push_back(static_cast<char>(deltaWidth));
+            data.push_back(static_cast<char>(runWidth));
+            BitWriter bits(data);
+            for (const auto& run : runs) bits.put(run.first, deltaWidth);
+            for (const auto& run : runs) bits.put(run.second - 1, runWidth);
+            for (size_t i = first; i < last; ++i) bits.put(doctorIds[rowOf(i)], doctorWidth);
+            for (size_t i = first; i < last; ++i) bits.put(patientIds[rowOf(i)], patientWidth);
+            bits.finish();
+
+            putBlock(directory, { 0, 0, static_cast<uint32_t>(last - first), timeOf(first), timeOf(last - 1), "", "" }, data);
+        }
+        putVarint(header, blockCount);
+        header += directory;
+    }
+
+    void writePatients(vector<ArchivedPatient>& rows) {
+        sort(rows.begin(), rows.end(), [](const ArchivedPatient& a, const ArchivedPatient& b) {
+            return a.name < b.name;
+        });
+        vector<string> names;
+        names.reserve(rows.size());
+        for (const auto& row : rows) names.push_back(row.name);
+
+        string directory;
+        size_t blockCount = 0;
+        for (size_t first = 0; first < rows.size(); first += archiveBlockRows, ++blockCount) {
+            size_t last = min(rows.size(), first + archiveBlockRows);
+            int64_t minCents = numeric_limits<int64_t>::max(), maxCents = numeric_limits<int64_t>::min();
+            uint64_t minPhone = numeric_limits<uint64_t>::max(), maxPhone = 0;
+            uint32_t maxAdmittances = 0;
+            uint32_t minMinutes = numeric_limits<uint32_t>::max(), maxMinutes = 0;
+            for (size_t i = first; i < last; ++i) {
+                if (!(fabs(rows[i].paymentDue) <= Patient::maxPaymentDue)) {
+                    throw runtime_error("Payment due of " + rows[i].name + " is out of range for the archive.");
+                }
+                int64_t cents = llround(rows[i].paymentDue * 100);
+                minCents = min(minCents, cents);
+                maxCents = max(maxCents, cents);
+                minPhone = min(minPhone, rows[i].phoneNumber);
+                maxPhone = max(maxPhone, rows[i].phoneNumber);
+                maxAdmittances = max(maxAdmittances, rows[i].previousAdmittances);
+                if (rows[i].hasAppointment) {
+                    minMinutes = min(minMinutes, rows[i].appointmentMinutes);
+                    maxMinutes = max(maxMinutes, rows[i].appointmentMinutes);
+                }
+            }
+            if (minMinutes > maxMinutes) minMinutes = maxMinutes = 0;
+            int centsWidth = bitsFor(static_cast<uint64_t>(maxCents) - static_cast<uint64_t>(minCents));
+            int phoneWidth = bitsFor(maxPhone - minPhone);
+            int admittanceWidth = bitsFor(maxAdmittances);
+            int minutesWidth = bitsFor(maxMinutes - minMinutes);
+
+            string data;
+            putVarint(data, static_cast<uint64_t>(minCents));
+            putVarint(data, minPhone);
+            data.push_back(static_cast<char>(centsWidth));
+            data.push_back(static_cast<char>(phoneWidth));
+            data.push_back(static_cast<char>(admittanceWidth));
+            data.push_back(static_cast<char>(minutesWidth));
+            putFrontCoded(data, names, first, last);
+            BitWriter bits(data);
+            for (size_t i = first; i < last; ++i) bits.put(rows[i].previousAdmittances, admittanceWidth);
+            for (size_t i = first; i < last; ++i) bits.put(static_cast<uint64_t>(llround(rows[i].paymentDue * 100)) - static_cast<uint64_t>(minCents), centsWidth);
+            for (size_t i = first; i < last; ++i) bits.put(rows[i].phoneNumber - minPhone, phoneWidth);
+            for (size_t i = first; i < last; ++i) bits.put(rows[i].hasAppointment, 1);
+            for (size_t i = first; i < last; ++i) {
+                if (rows[i].hasAppointment) bits.put(rows[i].appointmentMinutes - minMinutes, minutesWidth);
+            }
+            bits.finish();
+
+            putBlock(directory, { 0, 0, static_cast<uint32_t>(last - first), minMinutes, maxMinutes, rows[first].name, rows[last - 1].name }, data);
+        }
+        putVarint(header, blockCount);
+        header += directory;
+    }
+
+public:
+    // Writes the rows to path (patients are sorted in place); returns the file size
+    size_t write(const string& path, const vector<ArchivedAppointment>& appointments, vector<ArchivedPatient>& patients) {
+        size_t appointmentCsv = 0, patientCsv = 0;
+        for (const auto& row : appointments) appointmentCsv += csvBytes(row);
+        for (const auto& row : patients) patientCsv += csvBytes(row);
+        putVarint(header, appointmentCsv);
+        putVarint(header, patientCsv);
+        writeAppointments(appointments);
+        writePatients(patients);
+
+        string temporary = path + ".tmp";
+        ofstream out(temporary, ios::binary | ios::trunc);
+        uint64_t prefix[2] = { archiveMagic, header.size() };
+        out.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+        out << header << blocks;
+        if (!out.flush()) throw runtime_error("Cannot write archive " + temporary + ".");
+        out.close();
+
+        // The new archive must be on disk before it replaces the old one, and
+        // the rename must be on disk before the caller drops the live rows
+        int fd = open(temporary.c_str(), O_RDONLY);
+        bool synced = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0) close(fd);
+        if (!synced) throw runtime_error("Cannot sync archive " + temporary + ": " + strerror(errno));
+        if (rename(temporary.c_str(), path.c_str()) != 0) throw runtime_error("Cannot replace archive " + path + ".");
+        size_t slash = path.rfind('/');
+        string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        fd = open(directory.c_str(), O_RDONLY);
+        synced = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0) close(fd);
+        if (!synced) throw runtime_error("Cannot sync directory " + directory + ": " + strerror(errno));
+        return sizeof(prefix) + header.size() + blocks.size();
+    }
+};
+
+class ColumnArchive {
+private:
+    int fd;
+    uint64_t dataStart;
+    vector<string> doctors;
+    vector<string> patientNames;
+    vector<ArchiveBlock> appointmentBlocks;
+    vector<ArchiveBlock> patientBlocks;
+    string buffer;
+
+    static void readDirectory(const string& header, size_t& position, vector<ArchiveBlock>& blocks) {
+        size_t count = getVarint(header, position);
+        blocks.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            ArchiveBlock block;
+            block.offset = getVarint(header, position);
+            block.bytes = static_cast<uint32_t>(getVarint(header, position));
+            block.rows = static_cast<uint32_t>(getVarint(header, position));
+            block.minMinutes = static_cast<uint32_t>(getVarint(header, position));
+            block.maxMinutes = static_cast<uint32_t>(getVarint(header, position));
+            block.firstName = getText(header, position);
+            block.lastName = getText(header, position);
+            blocks.push_back(move(block));
+        }
+    }
+
+    const string& load(const ArchiveBlock& block, ArchiveScanStats& stats) {
+        buffer.assign(block.bytes + sizeof(uint64_t), '\0');
+        if (pread(fd, &buffer[0], block.bytes, dataStart + block.offset) != static_cast<ssize_t>(block.bytes)) {
+            throw runtime_error("Archive block is truncated.");
+        }
+        ++stats.blocksRead;
+        stats.bytesRead += block.bytes;
+        stats.rowsDecoded += block.rows;
+        return buffer;
+    }
+
+public:
+    size_t appointmentCsvBytes = 0;
+    size_t patientCsvBytes = 0;
+    size_t fileBytes = 0;
+
+    explicit ColumnArchive(const string& path) {
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Cannot open archive " + path + ": " + strerror(errno));
+        uint64_t prefix[2];
+        if (pread(fd, prefix, sizeof(prefix), 0) != static_cast<ssize_t>(sizeof(prefix)) || prefix[0] != archiveMagic) {
+            close(fd);
+            throw runtime_error(path + " is not an archive.");
+        }
+        string header(prefix[1], '\0');
+        if (pread(fd, &header[0], header.size(), sizeof(prefix)) != static_cast<ssize_t>(header.size())) {
+            close(fd);
+            throw runtime_error("Archive header is truncated.");
+        }
+        dataStart = sizeof(prefix) + header.size();
+        fileBytes = lseek(fd, 0, SEEK_END);
+
+        try {
+            size_t position = 0;
+            appointmentCsvBytes = getVarint(header, position);
+            patientCsvBytes = getVarint(header, position);
+            getFrontCoded(header, position, getVarint(header, position), doctors);
+            getFrontCoded(header, position, getVarint(header, position), patientNames);
+            readDirectory(header, position, appointmentBlocks);
+            readDirectory(header, position, patientBlocks);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    ColumnArchive(const ColumnArchive&) = delete;
+    ColumnArchive& operator=(const ColumnArchive&) = delete;
+
+    ~ColumnArchive() {
+        close(fd);
+    }
+
+    // Visits appointments in [from, to] in time order
+    template <typename Visitor>
+    size_t scanAppointments(uint32_t from, uint32_t to, ArchiveScanStats& stats, Visitor visit) {
+        int doctorWidth = bitsFor(doctors.empty() ? 0 : doctors.size() - 1);
+        int patientWidth = bitsFor(patientNames.empty() ? 0 : patientNames.size() - 1);
+        vector<uint32_t> runTimes, minutes, doctorIds;
+        size_t matched = 0;
+        for (const auto& block : appointmentBlocks) {
+            if (block.maxMinutes < from || block.minMinutes > to) {
+                ++stats.blocksSkipped;
+                continue;
+            }
+            const string& data = load(block, stats);
+            size_t position = 0;
+            size_t runCount = getVarint(data, position);
+            int deltaWidth = data[position];
+            int runWidth = data[position + 1];
+            BitReader bits(data.data(), position + 2);
+            runTimes.resize(runCount);
+            minutes.resize(block.rows);
+            doctorIds.resize(block.rows);
+            uint32_t time = block.minMinutes;
+            for (size_t run = 0; run < runCount; ++run) runTimes[run] = time += static_cast<uint32_t>(bits.get(deltaWidth));
+            for (size_t run = 0, row = 0; run < runCount; ++run) {
+                size_t length = bits.get(runWidth) + 1;
+                fill_n(minutes.begin() + row, length, runTimes[run]);
+                row += length;
+            }
+            for (size_t i = 0; i < block.rows; ++i) doctorIds[i] = static_cast<uint32_t>(bits.get(doctorWidth));
+            for (size_t i = 0; i < block.rows; ++i) {
+                uint32_t patientId = static_cast<uint32_t>(bits.get(patientWidth));
+                if (minutes[i] < from || minutes[i] > to) continue;
+                visit(patientNames[patientId], minutes[i], doctors[doctorIds[i]]);
+                ++matched;
+            }
+        }
+        return matched;
+    }
+
+    // Visits patients with names in [from, to] in name order
+    template <typename Visitor>
+    size_t scanPatients(const string& from, const string& to, ArchiveScanStats& stats, Visitor visit) {
+        vector<string> names;
+        vector<uint32_t> admittances;
+        vector<uint64_t> cents, phones;
+        size_t matched = 0;
+        for (const auto& block : patientBlocks) {
+            if (block.lastName < from || block.firstName > to) {
+                ++stats.blocksSkipped;
+                continue;
+            }
+            const string& data = load(block, stats);
+            size_t position = 0;
+            int64_t minCents = static_cast<int64_t>(getVarint(data, position));
+            uint64_t minPhone = getVarint(data, position);
+            int centsWidth = data[position];
+            int phoneWidth = data[position + 1];
+            int admittanceWidth = data[position + 2];
+            int minutesWidth = data[position + 3];
+            position += 4;
+            names.clear();
+            getFrontCoded(data, position, block.rows, names);
+
+            BitReader bits(data.data(), position);
+            admittances.resize(block.rows);
+            cents.resize(block.rows);
+            phones.resize(block.rows);
+            for (size_t i = 0; i < block.rows; ++i) admittances[i] = static_cast<uint32_t>(bits.get(admittanceWidth));
+            for (size_t i = 0; i < block.rows; ++i) cents[i] = bits.get(centsWidth);
+            for (size_t i = 0; i < block.rows; ++i) phones[i] = minPhone + bits.get(phoneWidth);
+            vector<bool> flags(block.rows);
+            for (size_t i = 0; i < block.rows; ++i) flags[i] = bits.get(1) != 0;
+            for (size_t i = 0; i < block.rows; ++i) {
+                uint32_t appointmentMinutes = flags[i] ? block.minMinutes + static_cast<uint32_t>(bits.get(minutesWidth)) : 0;
+                if (names[i] < from || names[i] > to) continue;
+                visit(ArchivedPatient{ names[i], admittances[i], static_cast<double>(static_cast<int64_t>(static_cast<uint64_t>(minCents) + cents[i])) / 100,
+                                       phones[i], flags[i], appointmentMinutes });
+                ++matched;
+            }
+        }
+        return matched;
+    }
+
+    size_t appointmentCount() const {
+        size_t rows = 0;
+        for (const auto& block : appointmentBlocks) rows += block.rows;
+        return rows;
+    }
+
+    size_t patientCount() const {
+        size_t rows = 0;
+        for (const auto& block : patientBlocks) rows += block.rows;
+        return rows;
+    }
+
+    size_t blockCount() const {
+        return appointmentBlocks.size() + patientBlocks.size();
+    }
+};
+
+ArchivedPatient archivedPatient(const Patient& patient) {
+    return { patient.getName(), static_cast<uint32_t>(patient.getPreviousAdmittances()), patient.getPaymentDue(),
+             patient.getPhoneNumber(), patient.hasAppointment(), patient.getAppointmentMinutes() };
+}
+
+void displayArchivedPatient(const ArchivedPatient& row) {
+    cout << row.name << "\t" << row.previousAdmittances << "\t" << row.paymentDue << "\t"
+         << (row.hasAppointment ? formatDateTime(row.appointmentMinutes) : "-") << "\t" << formatPhoneNumber(row.phoneNumber) << endl;
+}
+
+void reportArchiveScan(const ArchiveScanStats& stats, size_t matched, double seconds) {
+    cout << matched << " rows matched; blocks read " << stats.blocksRead << ", skipped " << stats.blocksSkipped
+         << "; decoded " << stats.rowsDecoded << " rows";
+    if (seconds > 0) {
+        cout << " at " << stats.rowsDecoded / seconds / 1e6 << " M rows/s (" << stats.bytesRead / seconds / (1024 * 1024) << " MB/s compressed)";
+    }
+    cout << endl;
+}
+
+uint32_t readArchiveTime(const string& prompt) {
+    string when;
+    cout << prompt;
+    getline(cin, when);
+    return packDateTime(when);
+}
+
+void manageArchive(AppointmentBook& appointments, vector<unique_ptr<Patient>>& patients, PhoneIndex& phoneIndex,
+                   PatientHistory& patientHistory) {
+    const size_t shownRows = 20;
+    cout << "\n--- Historical Archive ---" << endl;
+    cout << "1. Archive Appointments Before Date" << endl;
+    cout << "2. Generate Synthetic Archive" << endl;
+    cout << "3. Archived Appointments Between Dates" << endl;
+    cout << "4. Archived Patients in Name Range" << endl;
+    cout << "5. Archive Statistics and Full Scan" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int option = getValidIntegerInput("");
+        if (option < 1 || option > 5) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        string path;
+        cout << "Enter archive file path: ";
+        cin >> path;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        switch (option) {
+            case 1: {
+                uint32_t cutoff = readArchiveTime("Archive appointments before (YYYY-MM-DD HH:MM): ");
+                vector<ArchivedAppointment> archivedAppointments;
+                vector<ArchivedPatient> archivedPatients;
+                if (access(path.c_str(), F_OK) == 0) {
+                    ColumnArchive existing(path);
+                    ArchiveScanStats stats;
+                    existing.scanAppointments(0, numeric_limits<uint32_t>::max(), stats,
+                                              [&](const string& patient, uint32_t minutes, const string& doctor) {
+                        archivedAppointments.push_back({ patient, minutes, doctor });
+                    });
+                    existing.scanPatients("", string(256, '\xff'), stats, [&](const ArchivedPatient& row) {
+                        archivedPatients.push_back(row);
+                    });
+                }
+
+                // Nothing leaves the live book until the new archive is safely in place
+                unordered_set<const Appointment*> moved;
+                size_t unpackable = 0;
+                for (const Appointment* appointment : appointments.before(formatDateTime(cutoff))) {
+                    Parsed<uint32_t> minutes = parseDateTime(appointment->getDateAndTime());
+                    if (!minutes.ok()) {
+                        ++unpackable;
+                        continue;
+                    }
+                    archivedAppointments.push_back({ appointment->getPatientName(), minutes.value, appointment->getDoctorName() });
+                    moved.insert(appointment);
+                }
+
+                // Patients who owe nothing and have nothing booked from the
+                // cutoff on are cold; they replace any older archived row
+                unordered_set<string> booked;
+                for (const auto& appointment : appointments.all()) {
+                    if (moved.count(appointment.get()) == 0) booked.insert(appointment->getPatientName());
+                }
+                vector<bool> cold(patients.size(), false);
+                map<pair<string, uint64_t>, size_t> archivedRow;
+                for (size_t i = 0; i < archivedPatients.size(); ++i) {
+                    archivedRow[{ archivedPatients[i].name, archivedPatients[i].phoneNumber }] = i;
+                }
+                size_t coldCount = 0;
+                for (size_t handle = 0; handle < patients.size(); ++handle) {
+                    const Patient& patient = *patients[handle];
+                    string name = patient.getName();
+                    if (patient.getPaymentDue() != 0 || booked.count(name) > 0 ||
+                        (patient.hasAppointment() && patient.getAppointmentMinutes() >= cutoff)) {
+                        continue;
+                    }
+                    cold[handle] = true;
+                    ++coldCount;
+                    auto existing = archivedRow.find({ name, patient.getPhoneNumber() });
+                    if (existing != archivedRow.end()) {
+                        archivedPatients[existing->second] = archivedPatient(patient);
+                    } else {
+                        archivedPatients.push_back(archivedPatient(patient));
+                    }
+                }
+
+                size_t bytes = ColumnArchiveWriter().write(path, archivedAppointments, archivedPatients);
+                appointments.remove(moved);
+                unregisterPatients(patients, phoneIndex, patientHistory, cold);
+                cout << "Moved " << moved.size() << " appointments and " << coldCount << " patients into " << path << " ("
+                     << archivedAppointments.size() << " archived appointments, " << archivedPatients.size()
+                     << " patients, " << bytes << " bytes)" << endl;
+                if (unpackable > 0) {
+                    cout << unpackable << " appointments have dates the archive cannot hold and stay in the book." << endl;
+                }
+                break;
+            }
+            case 2: {
+                int appointmentCount = getValidIntegerInput("Number of appointments: ");
+                int patientCount = getValidIntegerInput("Number of patients: ");
+                int doctorCount = getValidIntegerInput("Number of doctors: ");
+                if (appointmentCount < 0 || patientCount < 1 || doctorCount < 1) {
+                    throw InvalidInputException("Counts must be positive.");
+                }
+                mt19937_64 random(random_device{}());
+                vector<ArchivedPatient> archivedPatients;
+                archivedPatients.reserve(patientCount);
+                for (int i = 0; i < patientCount; ++i) archivedPatients.push_back(archivedPatient(randomPatient(random)));
+                vector<ArchivedAppointment> archivedAppointments;
+                archivedAppointments.reserve(appointmentCount);
+                // Five years of history ending 2025-01-01, in office hours
+                uint32_t firstDay = packDateTime("2020-01-01 00:00") / 1440;
+                for (int i = 0; i < appointmentCount; ++i) {
+                    uint32_t minutes = (firstDay + static_cast<uint32_t>(random() % 1827)) * 1440 + 540 + static_cast<uint32_t>(random() % 32) * 15;
+                    archivedAppointments.push_back({ archivedPatients[random() % patientCount].name, minutes,
+                                                     "Dr. Staff " + to_string(random() % doctorCount) });
+                }
+                auto start = chrono::steady_clock::now();
+                size_t bytes = ColumnArchiveWriter().write(path, archivedAppointments, archivedPatients);
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                cout << "Wrote " << bytes << " bytes in " << seconds << " s" << endl;
+                break;
+            }
+            case 3: {
+                uint32_t from = readArchiveTime("Enter start (YYYY-MM-DD HH:MM): ");
+                uint32_t to = readArchiveTime("Enter end (YYYY-MM-DD HH:MM): ");
+                ColumnArchive archive(path);
+                ArchiveScanStats stats;
+                auto start = chrono::steady_clock::now();
+                size_t matched = archive.scanAppointments(from, to, stats, [&, shown = size_t(0)](const string& patient, uint32_t minutes, const string& doctor) mutable {
+                    if (shown++ < shownRows) cout << formatDateTime(minutes) << "\t" << doctor << "\t" << patient << endl;
+                });
+                reportArchiveScan(stats, matched, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+                break;
+            }
+            case 4: {
+                string from, to;
+                cout << "Enter first name in range: ";
+                getline(cin, from);
+                cout << "Enter last name in range: ";
+                getline(cin, to);
+                ColumnArchive archive(path);
+                ArchiveScanStats stats;
+                auto start = chrono::steady_clock::now();
+                size_t matched = archive.scanPatients(from, to, stats, [&, shown = size_t(0)](const ArchivedPatient& row) mutable {
+                    if (shown++ < shownRows) displayArchivedPatient(row);
+                });
+                reportArchiveScan(stats, matched, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+                break;
+            }
+            case 5: {
+                ColumnArchive archive(path);
+                size_t csv = archive.appointmentCsvBytes + archive.patientCsvBytes;
+                cout << "Appointments: " << archive.appointmentCount() << ", patients: " << archive.patientCount()
+                     << ", blocks: " << archive.blockCount() << endl;
+                cout << "Archive: " << archive.fileBytes << " bytes; as CSV: " << csv << " bytes";
+                if (archive.fileBytes > 0) cout << " (" << static_cast<double>(csv) / archive.fileBytes << "x smaller)";
+                cout << endl;
+
+                ArchiveScanStats stats;
+                auto start = chrono::steady_clock::now();
+                size_t matched = archive.scanAppointments(0, numeric_limits<uint32_t>::max(), stats, [](const string&, uint32_t, const string&) {});
+                cout << "Appointment scan: ";
+                reportArchiveScan(stats, matched, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+                stats = ArchiveScanStats();
+                start = chrono::steady_clock::now();
+                matched = archive.scanPatients("", string(1, '\x7f'), stats, [](const ArchivedPatient&) {});
+                cout << "Patient scan: ";
+                reportArchiveScan(stats, matched, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+                break;
+            }
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void reportRegistryIo(const PatientStore& registry, uint64_t readsBefore, uint64_t hitsBefore) {
+    const BufferPool& pool = registry.bufferPool();
+    cout << "Page reads: " << pool.pageReads - readsBefore << ", buffer hits: " << pool.hits - hitsBefore
+         << " (tree height " << registry.height() << ")" << endl;
+}
+
+void generateRegistryPatients(PatientStore& registry, int count) {
+    mt19937_64 random(random_device{}());
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        registry.insert(randomPatient(random));
+    }
+    registry.flush();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Inserted " << count << " patients in " << seconds << " s";
+    if (seconds > 0) cout << " (" << count / seconds << " inserts/s)";
+    cout << endl;
+}
+
+// Patients added while a registry is open are written through to it, and
+// Search Patient by Name falls back to it, so it can hold far more patients
+// than are kept in memory. Import copies in the patients added before it was opened.
+void manageDiskRegistry(unique_ptr<PatientStore>& registry, const vector<unique_ptr<Patient>>& patients) {
+    cout << "\n--- Disk Patient Registry ---" << endl;
+    cout << "1. Open Registry File" << endl;
+    cout << "2. Import Current Patients" << endl;
+    cout << "3. Find Patient by Name" << endl;
+    cout << "4. List Patients in Name Range" << endl;
+    cout << "5. Generate Synthetic Patients" << endl;
+    cout << "6. Registry Statistics" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int option = getValidIntegerInput("");
+        if (option < 1 || option > 6) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        if (option == 1) {
+            string path;
+            cout << "Enter registry file path: ";
+            cin >> path;
+            int poolMegabytes = getValidIntegerInput("Buffer pool size in MiB: ");
+            if (poolMegabytes < 1) {
+                throw InvalidInputException("Buffer pool size must be positive.");
+            }
+            openRegistry = nullptr;
+            registry.reset();
+            registry = make_unique<PatientStore>(path, static_cast<size_t>(poolMegabytes) * 1024 * 1024 / registryPageSize);
+            openRegistry = registry.get();
+            cout << "Registry opened with " << registry->recordCount() << " patients." << endl;
+            return;
+        }
+        if (!registry) {
+            cout << "No registry is open." << endl;
+            return;
+        }
+
+        const BufferPool& pool = registry->bufferPool();
+        uint64_t readsBefore = pool.pageReads;
+        uint64_t hitsBefore = pool.hits;
+        switch (option) {
+            case 2: {
+                // Patients already stored under the same name and phone are
+                // skipped, so importing twice does not duplicate them
+                size_t imported = 0, present = 0;
+                vector<string> rejected;
+                for (const auto& patient : patients) {
+                    string name = patient->getName();
+                    if (name.size() > sizeof(RegistryKey::name)) {
+                        rejected.push_back(name);
+                    } else if (registry->contains(name, patient->getPhoneNumber())) {
+                        ++present;
+                    } else {
+                        registry->insert(*patient);
+                        ++imported;
+                    }
+                }
+                registry->flush();
+                cout << "Imported " << imported << " patients, " << present << " already in the registry." << endl;
+                for (const auto& name : rejected) {
+                    cout << "Skipped '" << name << "': registry names are limited to " << sizeof(RegistryKey::name) << " characters." << endl;
+                }
+                break;
+            }
+            case 3: {
+                string name;
+                cout << "Enter the name of the patient to search: ";
+                cin >> name;
+                size_t found = registry->findByName(name, [](uint32_t id, const Patient& patient) {
+                    cout << "Registry ID: " << id << endl;
+                    displayDetails(patient);
+                });
+                if (found == 0) cout << "Patient with name '" << name << "' not found." << endl;
+                reportRegistryIo(*registry, readsBefore, hitsBefore);
+                break;
+            }
+            case 4: {
+                string from, to;
+                cout << "Enter first name in range: ";
+                cin >> from;
+                cout << "Enter last name in range: ";
+                cin >> to;
+                int limit = getValidIntegerInput("Maximum patients to list: ");
+                if (limit < 1) {
+                    throw InvalidInputException("Limit must be positive.");
+                }
+                size_t found = registry->scanNames(from, to, limit, [](uint32_t id, const Patient& patient) {
+                    cout << id << "\t" << patient.getName() << "\t" << formatPhoneNumber(patient.getPhoneNumber())
+                         << "\t" << patient.getPaymentDue() << endl;
+                });
+                cout << found << " patients listed." << endl;
+                reportRegistryIo(*registry, readsBefore, hitsBefore);
+                break;
+            }
+            case 5: {
+                int count = getValidIntegerInput("Number of patients to generate: ");
+                if (count < 1) {
+                    throw InvalidInputException("Count must be positive.");
+                }
+                generateRegistryPatients(*registry, count);
+                reportRegistryIo(*registry, readsBefore, hitsBefore);
+                break;
+            }
+            case 6:
+                cout << "Patients: " << registry->recordCount() << endl;
+                cout << "Tree height: " << registry->height() << endl;
+                cout << "Pages: " << registry->pageCount() << " (" << registry->pageCount() * registryPageSize / (1024 * 1024) << " MiB)" << endl;
+                cout << "Buffer pool: " << pool.frameCount() << " frames (" << pool.frameCount() * registryPageSize / (1024 * 1024) << " MiB)" << endl;
+                cout << "Buffer hits: " << pool.hits << ", misses: " << pool.misses << endl;
+                cout << "Page reads: " << pool.pageReads << ", page writes: " << pool.pageWrites << endl;
+                break;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+void manageLazyPatients(unique_ptr<LazyPatientTable>& table, const vector<unique_ptr<Patient>>& patients) {
+    cout << "\n--- Lazy Patient Table ---" << endl;
+    cout << "1. Save Current Patients to Segments" << endl;
+    cout << "2. Generate Synthetic Segments" << endl;
+    cout << "3. Load Hot Segment" << endl;
+    cout << "4. Find Patient by Name" << endl;
+    cout << "5. Dues and Appointment Summary" << endl;
+    cout << "6. Cold Field Access Benchmark" << endl;
+    cout << "7. Cache Statistics" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int option = getValidIntegerInput("");
+        if (option < 1 || option > 7) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        if (option <= 3) {
+            string basePath;
+            cout << "Enter segment base path: ";
+            cin >> basePath;
+            if (option == 1) {
+                writePatientSegments(basePath, patients);
+                cout << "Saved " << patients.size() << " patients to " << basePath << ".hot and " << basePath << ".cold" << endl;
+            } else if (option == 2) {
+                int count = getValidIntegerInput("Number of patients to generate: ");
+                if (count < 1) {
+                    throw InvalidInputException("Count must be positive.");
+                }
+                mt19937_64 random(random_device{}());
+                vector<unique_ptr<Patient>> generated;
+                generated.reserve(count);
+                for (int i = 0; i < count; ++i) {
+                    generated.push_back(make_unique<Patient>(randomPatient(random)));
+                }
+                writePatientSegments(basePath, generated);
+                cout << "Saved " << count << " patients to " << basePath << ".hot and " << basePath << ".cold" << endl;
+            } else {
+                int cacheEntries = getValidIntegerInput("Cold field cache entries: ");
+                if (cacheEntries < 1) {
+                    throw InvalidInputException("Cache size must be positive.");
+                }
+                loadedPatients = nullptr;
+                table.reset();
+                auto start = chrono::steady_clock::now();
+                table = make_unique<LazyPatientTable>(basePath, cacheEntries);
+                loadedPatients = table.get();
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                size_t eagerBytes = table->size() * sizeof(Patient);
+                cout << "Loaded " << table->size() << " patients in " << seconds << " s" << endl;
+                cout << "Resident: " << table->residentBytes() << " bytes (fully loaded Patient records: " << eagerBytes
+                     << " bytes plus name overflow)" << endl;
+                cout << "Left on disk: " << table->size() * sizeof(ColdPatientFields) << " bytes of cold fields" << endl;
+            }
+            return;
+        }
+        if (!table) {
+            cout << "No segments are loaded." << endl;
+            return;
+        }
+
+        switch (option) {
+            case 4: {
+                string name;
+                cout << "Enter the name of the patient to search: ";
+                cin >> name;
+                uint32_t handle;
+                if (table->findByName(name, handle)) {
+                    cout << "Patient found:" << endl;
+                    displayDetails(table->materialize(handle));
+                } else {
+                    cout << "Patient with name '" << name << "' not found." << endl;
+                }
+                break;
+            }
+            case 5:
+                cout << "Patients: " << table->size() << endl;
+                cout << "Total payment due: " << table->totalDues() << endl;
+                cout << "Patients with appointments: " << table->appointmentCount() << endl;
+                break;
+            case 6: {
+                int accesses = getValidIntegerInput("Number of accesses: ");
+                if (accesses < 1 || table->size() == 0) {
+                    throw InvalidInputException("Need a positive access count and a non-empty table.");
+                }
+                // 80% of accesses go to 20% of the patients
+                mt19937_64 random(random_device{}());
+                size_t hotSet = max<size_t>(table->size() / 5, 1);
+                uint64_t hitsBefore = table->hits;
+                auto start = chrono::steady_clock::now();
+                for (int i = 0; i < accesses; ++i) {
+                    size_t handle = random() % 10 < 8 ? random() % hotSet : random() % table->size();
+                    table->coldFields(static_cast<uint32_t>(handle));
+                }
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                cout << accesses << " accesses in " << seconds << " s (" << seconds * 1e9 / accesses << " ns each), hit rate "
+                     << 100.0 * (table->hits - hitsBefore) / accesses << "%" << endl;
+                break;
+            }
+            case 7: {
+                uint64_t lookups = table->hits + table->misses;
+                cout << "Cached entries: " << table->cachedEntries() << " of " << table->cacheCapacity() << endl;
+                cout << "Hits: " << table->hits << ", misses: " << table->misses << endl;
+                cout << "Hit rate: " << (lookups ? 100.0 * table->hits / lookups : 0.0) << "%" << endl;
+                break;
+            }
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// A day's appointment request: a patient, an optional preferred doctor and
+// the window of slots the patient can attend
+struct AppointmentRequest {
+    string patient;
+    int preferredDoctor;   // index into the roster, or -1
+    uint32_t firstSlot;
+    uint32_t lastSlot;
+};
+
+struct SlotAssignment {
+    int doctor;            // -1 when no doctor was free in the window
+    uint32_t slot;
+};
+
+// Assigns requests to a roster of doctors over one day of equal slots.
+// Each slot keeps a min-heap of (load, doctor) for the doctors free in it,
+// so the least-loaded doctor free anywhere in a window is found from the
+// heap tops. Entries go stale when a doctor's load changes or the slot is
+// booked, and are dropped when they reach the top.
+class BatchScheduler {
+private:
+    typedef pair<uint32_t, uint32_t> Candidate;
+    typedef priority_queue<Candidate, vector<Candidate>, greater<Candidate>> CandidateHeap;
+
+    size_t slotCount;
+    vector<uint32_t> load;
+    vector<char> booked;   // doctor-major slot grid
+    vector<CandidateHeap> freeDoctors;
+
+    bool isFree(uint32_t doctor, uint32_t slot) const {
+        return !booked[doctor * slotCount + slot];
+    }
+
+    void book(uint32_t doctor, uint32_t slot) {
+        booked[doctor * slotCount + slot] = 1;
+        ++load[doctor];
+        for (uint32_t other = 0; other < slotCount; ++other) {
+            if (isFree(doctor, other)) freeDoctors[other].emplace(load[doctor], doctor);
+        }
+    }
+
+    // Least-loaded doctor still free in slot, or false if none
+    bool topOf(uint32_t slot, Candidate& best) {
+        CandidateHeap& heap = freeDoctors[slot];
+        while (!heap.empty()) {
+            const Candidate& top = heap.top();
+            if (isFree(top.second, slot) && load[top.second] == top.first) {
+                best = top;
+                return true;
+            }
+            heap.pop();
+        }
+        return false;
+    }
+
+public:
+    BatchScheduler(size_t doctorCount, size_t slots)
+        : slotCount(slots), load(doctorCount, 0), booked(doctorCount * slots, 0) {
+        vector<Candidate> everyone;
+        everyone.reserve(doctorCount);
+        for (uint32_t doctor = 0; doctor < doctorCount; ++doctor) everyone.emplace_back(0, doctor);
+        freeDoctors.reserve(slots);
+        for (size_t slot = 0; slot < slots; ++slot) {
+            freeDoctors.emplace_back(greater<Candidate>(), everyone);
+        }
+    }
+
+    // A slot the doctor already has booked; counts towards the doctor's load
+    void reserve(uint32_t doctor, uint32_t slot) {
+        if (isFree(doctor, slot)) book(doctor, slot);
+    }
+
+    // Earliest slot in the window with the preferred doctor, if any
+    bool assignPreferred(uint32_t doctor, const AppointmentRequest& request, SlotAssignment& result) {
+        for (uint32_t slot = request.firstSlot; slot <= request.lastSlot; ++slot) {
+            if (isFree(doctor, slot)) {
+                book(doctor, slot);
+                result = { static_cast<int>(doctor), slot };
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Least-loaded doctor free anywhere in the window, earliest slot on ties
+    bool assignLeastLoaded(const AppointmentRequest& request, SlotAssignment& result) {
+        Candidate best{ numeric_limits<uint32_t>::max(), 0 };
+        uint32_t bestSlot = 0;
+        bool found = false;
+        for (uint32_t slot = request.firstSlot; slot <= request.lastSlot; ++slot) {
+            Candidate candidate;
+            if (topOf(slot, candidate) && (!found || candidate.first < best.first)) {
+                best = candidate;
+                bestSlot = slot;
+                found = true;
+            }
+        }
+        if (!found) return false;
+        book(best.second, bestSlot);
+        result = { static_cast<int>(best.second), bestSlot };
+        return true;
+    }
+};
+
+struct ScheduleSummary {
+    size_t assigned = 0;
+    size_t unassigned = 0;
+    size_t preferred = 0;
+    size_t preferenceHonoured = 0;
+};
+
+// Schedules the most constrained requests (narrowest windows) first, around
+// the (doctor, slot) pairs already booked.
+// A free preferred doctor wins; otherwise the least-loaded free doctor does.
+vector<SlotAssignment> scheduleRequests(const vector<AppointmentRequest>& requests, size_t doctorCount, size_t slotCount,
+                                        const vector<pair<uint32_t, uint32_t>>& busy, ScheduleSummary& summary) {
+    vector<uint32_t> order(requests.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<uint32_t>(i);
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return requests[a].lastSlot - requests[a].firstSlot < requests[b].lastSlot - requests[b].firstSlot;
+    });
+
+    BatchScheduler scheduler(doctorCount, slotCount);
+    for (const auto& booking : busy) scheduler.reserve(booking.first, booking.second);
+    vector<SlotAssignment> assignments(requests.size(), SlotAssignment{ -1, 0 });
+    for (uint32_t index : order) {
+        const AppointmentRequest& request = requests[index];
+        SlotAssignment& result = assignments[index];
+        if (request.preferredDoctor >= 0) {
+            ++summary.preferred;
+            if (scheduler.assignPreferred(request.preferredDoctor, request, result)) {
+                ++summary.preferenceHonoured;
+                ++summary.assigned;
+                continue;
+            }
+        }
+        if (scheduler.assignLeastLoaded(request, result)) {
+            ++summary.assigned;
+        } else {
+            ++summary.unassigned;
+        }
+    }
+    return assignments;
+}
+
+// Minutes since midnight for HH:MM
+Parsed<uint32_t> parseClockTime(string_view clock) {
+    if (clock.size() != 5) return { 0, clock.empty() ? ParseError::Empty : ParseError::Invalid };
+    char dateTime[] = "2000-01-01 HH:MM";
+    memcpy(dateTime + 11, clock.data(), 5);
+    return parseDateTime(dateTime);
+}
+
+uint32_t minutesOfDay(const string& clock) {
+    Parsed<uint32_t> parsed = parseClockTime(clock);
+    if (!parsed.ok()) {
+        throw InvalidInputException("Invalid time of day. Use HH:MM.");
+    }
+    return parsed.value;
+}
+
+// Reads "patient,preferred doctor (may be empty),HH:MM,HH:MM" lines
+vector<AppointmentRequest> loadAppointmentRequests(const string& path, const vector<string>& roster,
+                                                   uint32_t dayStart, uint32_t slotMinutes, uint32_t slotCount) {
+    ifstream in(path);
+    if (!in) throw runtime_error("Cannot open " + path + ".");
+    unordered_map<string, int> rosterIndex;
+    for (size_t i = 0; i < roster.size(); ++i) rosterIndex.emplace(roster[i], static_cast<int>(i));
+
+    vector<AppointmentRequest> requests;
+    string line;
+    size_t lineNumber = 0, skipped = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        stringstream fields(line);
+        string patient, doctor, from, to;
+        if (!getline(fields, patient, ',') || !getline(fields, doctor, ',') || !getline(fields, from, ',') || !getline(fields, to)) {
+            ++skipped;
+            continue;
+        }
+        Parsed<uint32_t> opens = parseClockTime(from), closes = parseClockTime(to);
+        if (!opens.ok() || !closes.ok() || opens.value < dayStart || closes.value < opens.value) {
+            ++skipped;
+            continue;
+        }
+        uint32_t first = (opens.value - dayStart + slotMinutes - 1) / slotMinutes;
+        uint32_t last = min((closes.value - dayStart) / slotMinutes, slotCount - 1);
+        if (first > last) {
+            ++skipped;
+            continue;
+        }
+        auto doctorIt = rosterIndex.find(doctor);
+        requests.push_back({ patient, doctorIt == rosterIndex.end() ? -1 : doctorIt->second, first, last });
+    }
+    if (skipped > 0) cout << "Skipped " << skipped << " of " << lineNumber << " lines." << endl;
+    return requests;
+}
+
+vector<AppointmentRequest> generateAppointmentRequests(size_t count, int preferencePercent, size_t doctorCount, uint32_t slotCount) {
+    mt19937_64 random(random_device{}());
+    vector<AppointmentRequest> requests;
+    requests.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t first = random() % slotCount;
+        uint32_t width = random() % max<uint32_t>(slotCount / 2, 1);
+        int preferred = static_cast<int>(random() % 100) < preferencePercent ? static_cast<int>(random() % doctorCount) : -1;
+        requests.push_back({ "Patient" + to_string(i), preferred, first, min(first + width, slotCount - 1) });
+    }
+    return requests;
+}
+
+// Slots of the day each roster doctor already has booked. An appointment is
+// taken to last one slot, so one off the slot grid blocks both slots it overlaps.
+vector<pair<uint32_t, uint32_t>> bookedSlots(const AppointmentBook& appointments, const vector<string>& roster,
+                                             uint32_t dayOpens, uint32_t slotMinutes, uint32_t slotCount) {
+    unordered_map<string, uint32_t> rosterIndex;
+    for (size_t i = 0; i < roster.size(); ++i) rosterIndex.emplace(roster[i], static_cast<uint32_t>(i));
+    uint32_t dayCloses = dayOpens + slotMinutes * slotCount;
+
+    vector<pair<uint32_t, uint32_t>> busy;
+    for (const auto& appointment : appointments.all()) {
+        auto doctorIt = rosterIndex.find(appointment->getDoctorName());
+        if (doctorIt == rosterIndex.end()) continue;
+        Parsed<uint32_t> minutes = parseDateTime(appointment->getDateAndTime());
+        if (!minutes.ok() || minutes.value + slotMinutes <= dayOpens || minutes.value >= dayCloses) continue;
+        uint32_t first = minutes.value <= dayOpens ? 0 : (minutes.value - dayOpens) / slotMinutes;
+        uint32_t last = min((minutes.value + slotMinutes - 1 - dayOpens) / slotMinutes, slotCount - 1);
+        for (uint32_t slot = first; slot <= last; ++slot) busy.emplace_back(doctorIt->second, slot);
+    }
+    sort(busy.begin(), busy.end());
+    busy.erase(unique(busy.begin(), busy.end()), busy.end());
+    return busy;
+}
+
+void batchScheduleAppointments(AppointmentBook& appointments, const vector<unique_ptr<Patient>>& patients,
+                               const vector<unique_ptr<Doctor>>& doctors) {
+    try {
+        string date, dayStartText, dayEndText;
+        cout << "Enter date (YYYY-MM-DD): ";
+        cin >> date;
+        uint32_t dayMinutes = packDateTime(date + " 00:00");
+        cout << "Enter first slot time (HH:MM): ";
+        cin >> dayStartText;
+        cout << "Enter closing time (HH:MM): ";
+        cin >> dayEndText;
+        uint32_t dayStart = minutesOfDay(dayStartText), dayEnd = minutesOfDay(dayEndText);
+        int slotMinutes = getValidIntegerInput("Slot length in minutes: ");
+        if (slotMinutes < 5 || dayEnd <= dayStart || dayEnd - dayStart < static_cast<uint32_t>(slotMinutes)) {
+            throw InvalidInputException("Slots must be at least 5 minutes and fit between opening and closing.");
+        }
+        uint32_t slotCount = (dayEnd - dayStart) / slotMinutes;
+
+        // Extra doctors only exist for this run; the hospital roster is untouched
+        int extraDoctors = getValidIntegerInput("Scratch doctors to add for this run (0 for none): ");
+        if (extraDoctors < 0) {
+            throw InvalidInputException("Doctor count cannot be negative.");
+        }
+        vector<string> roster;
+        for (const auto& doctor : doctors) roster.push_back(doctor->getName());
+        for (int i = 0; i < extraDoctors; ++i) {
+            roster.push_back("Dr. Roster " + to_string(doctors.size() + i + 1));
+        }
+        if (roster.empty()) {
+            cout << "No doctors on the roster." << endl;
+            return;
+        }
+
+        vector<AppointmentRequest> requests;
+        int source = getValidIntegerInput("Requests (1. From file, 2. Synthetic): ");
+        if (source == 1) {
+            string path;
+            cout << "Enter request file path: ";
+            cin >> path;
+            requests = loadAppointmentRequests(path, roster, dayStart, slotMinutes, slotCount);
+        } else if (source == 2) {
+            int count = getValidIntegerInput("Number of requests: ");
+            int preferencePercent = getValidIntegerInput("Percent with a preferred doctor: ");
+            if (count < 1 || preferencePercent < 0 || preferencePercent > 100) {
+                throw InvalidInputException("Need a positive count and a percentage from 0 to 100.");
+            }
+            requests = generateAppointmentRequests(count, preferencePercent, roster.size(), slotCount);
+        } else {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+
+        vector<pair<uint32_t, uint32_t>> busy = bookedSlots(appointments, roster, dayMinutes + dayStart, slotMinutes, slotCount);
+        ScheduleSummary summary;
+        auto start = chrono::steady_clock::now();
+        vector<SlotAssignment> assignments = scheduleRequests(requests, roster.size(), slotCount, busy, summary);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        vector<uint32_t> loads(roster.size(), 0);
+        for (const auto& booking : busy) ++loads[booking.first];
+        for (const auto& assignment : assignments) {
+            if (assignment.doctor >= 0) ++loads[assignment.doctor];
+        }
+        double mean = static_cast<double>(summary.assigned + busy.size()) / loads.size(), variance = 0;
+        size_t full = 0;
+        for (uint32_t load : loads) {
+            variance += (load - mean) * (load - mean);
+            if (load == slotCount) ++full;
+        }
+        auto extremes = minmax_element(loads.begin(), loads.end());
+
+        cout << "Scheduled " << requests.size() << " requests over " << roster.size() << " doctors x " << slotCount
+             << " slots in " << seconds << " s, around " << busy.size() << " slots already booked" << endl;
+        cout << "Assigned: " << summary.assigned << ", unassigned: " << summary.unassigned << endl;
+        cout << "Preferred doctor honoured: " << summary.preferenceHonoured << " of " << summary.preferred << endl;
+        cout << "Load per doctor: min " << *extremes.first << ", max " << *extremes.second << ", mean " << mean
+             << ", std dev " << sqrt(variance / loads.size()) << ", fully booked " << full << endl;
+
+        // Only registered patients with hospital doctors go into the real book
+        unordered_set<string> registered;
+        for (const auto& patient : patients) registered.insert(patient->getName());
+        size_t bookable = 0;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (assignments[i].doctor >= 0 && static_cast<size_t>(assignments[i].doctor) < doctors.size() &&
+                registered.count(requests[i].patient) > 0) {
+                ++bookable;
+            }
+        }
+        if (bookable == 0) {
+            cout << "No assignment is for a registered patient with a hospital doctor; nothing to book." << endl;
+            return;
+        }
+        cout << bookable << " of " << summary.assigned << " assignments are for registered patients with hospital doctors." << endl;
+        if (getYesNoInput("Add those assignments to the appointment book?")) {
+            for (size_t i = 0; i < requests.size(); ++i) {
+                if (assignments[i].doctor < 0 || static_cast<size_t>(assignments[i].doctor) >= doctors.size() ||
+                    registered.count(requests[i].patient) == 0) {
+                    continue;
+                }
+                uint32_t minutes = dayMinutes + dayStart + assignments[i].slot * slotMinutes;
+                appointments.add(requests[i].patient, formatDateTime(minutes), doctors[assignments[i].doctor]->getName());
+            }
+            cout << bookable << " appointments booked." << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Monthly payroll policy: income tax above a tax-free allowance, and a
+// pension contribution on the whole monthly salary
+constexpr double payrollTaxFreeMonthly = 1000.0;
+constexpr double payrollTaxRate = 0.20;
+constexpr double payrollPensionRate = 0.05;
+
+enum class StaffRole { Doctor, Nurse, Receptionist, Administrator };
+
+const char* const staffRoleNames[] = { "Doctor", "Nurse", "Receptionist", "Administrator" };
+constexpr size_t staffRoleCount = sizeof(staffRoleNames) / sizeof(staffRoleNames[0]);
+
+// One role's payroll as columns; index i across the vectors is one person
+struct RolePayroll {
+    vector<string> names;
+    vector<double> annual;
+    vector<double> gross;
+    vector<double> tax;
+    vector<double> pension;
+    vector<double> net;
+};
+
+struct PayrollTotals {
+    size_t staff = 0;
+    double gross = 0;
+    double tax = 0;
+    double pension = 0;
+    double net = 0;
+};
+
+// Branch-free over plain arrays, so the compiler can vectorize it (GCC
+// does at -O3; -O2 needs -fvect-cost-model=cheap)
+void computePayroll(const double* __restrict__ annual, double* __restrict__ gross, double* __restrict__ tax,
+                    double* __restrict__ pension, double* __restrict__ net, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        double monthly = annual[i] / 12.0;
+        // (x + |x|) / 2 is max(x, 0) without the compare that blocks vectorization
+        double taxable = monthly - payrollTaxFreeMonthly;
+        double withheld = (taxable + fabs(taxable)) * (payrollTaxRate / 2);
+        double contribution = monthly * payrollPensionRate;
+        gross[i] = monthly;
+        tax[i] = withheld;
+        pension[i] = contribution;
+        net[i] = monthly - withheld - contribution;
+    }
+}
+
+class PayrollRun {
+private:
+    RolePayroll roles[staffRoleCount];
+
+public:
+    void add(StaffRole role, const string& name, double annualSalary) {
+        RolePayroll& payroll = roles[static_cast<size_t>(role)];
+        payroll.names.push_back(name);
+        payroll.annual.push_back(annualSalary);
+    }
+
+    template <typename Member>
+    void addStaff(StaffRole role, const vector<unique_ptr<Member>>& staff) {
+        for (const auto& member : staff) add(role, member->getName(), member->getSalary());
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (const auto& payroll : roles) count += payroll.names.size();
+        return count;
+    }
+
+    // Splits every role into slices and computes them on worker threads
+    void compute(unsigned workers) {
+        const size_t minimumSlice = 16384;
+        vector<thread> threads;
+        for (auto& payroll : roles) {
+            size_t count = payroll.annual.size();
+            payroll.gross.resize(count);
+            payroll.tax.resize(count);
+            payroll.pension.resize(count);
+            payroll.net.resize(count);
+            size_t slice = max(minimumSlice, (count + workers - 1) / workers);
+            for (size_t first = 0; first < count; first += slice) {
+                size_t length = min(slice, count - first);
+                RolePayroll* target = &payroll;
+                auto work = [target, first, length]() {
+                    computePayroll(&target->annual[first], &target->gross[first], &target->tax[first],
+                                   &target->pension[first], &target->net[first], length);
+                };
+                if (workers > 1) {
+                    threads.emplace_back(work);
+                } else {
+                    work();
+                }
+            }
+        }
+        for (auto& worker : threads) worker.join();
+    }
+
+    PayrollTotals totals() const {
+        PayrollTotals sum;
+        for (const auto& payroll : roles) {
+            sum.staff += payroll.net.size();
+            for (size_t i = 0; i < payroll.net.size(); ++i) {
+                sum.gross += payroll.gross[i];
+                sum.tax += payroll.tax[i];
+                sum.pension += payroll.pension[i];
+                sum.net += payroll.net[i];
+            }
+        }
+        return sum;
+    }
+
+    void writeReport(ExportWriter& writer) const {
+        writer.header({ "role", "name", "annual_salary", "monthly_gross", "tax", "pension", "net_pay" });
+        for (size_t role = 0; role < staffRoleCount; ++role) {
+            const RolePayroll& payroll = roles[role];
+            size_t roleNameLength = strlen(staffRoleNames[role]);
+            for (size_t i = 0; i < payroll.net.size(); ++i) {
+                writer.beginRecord();
+                writer.field("role", staffRoleNames[role], roleNameLength);
+                writer.field("name", payroll.names[i]);
+                writer.field("annual_salary", payroll.annual[i]);
+                writer.field("monthly_gross", payroll.gross[i]);
+                writer.field("tax", payroll.tax[i]);
+                writer.field("pension", payroll.pension[i]);
+                writer.field("net_pay", payroll.net[i]);
+                writer.endRecord();
+            }
+        }
+        writer.flush();
+    }
+};
+
+void displayPayrollTotals(const PayrollTotals& totals) {
+    ostringstream amounts;
+    amounts << fixed << setprecision(2) << "Gross: $" << totals.gross << ", tax: $" << totals.tax
+            << ", pension: $" << totals.pension << ", net: $" << totals.net;
+    cout << "Staff paid: " << totals.staff << endl;
+    cout << amounts.str() << endl;
+}
+
+// Times the existing per-object path (a virtual displayEarnings() call
+// per person, printing to a file) against the columnar payroll run
+void benchmarkPayroll(int staffCount, const string& path, unsigned workers) {
+    vector<unique_ptr<Staff>> staff;
+    PayrollRun payroll;
+    staff.reserve(staffCount);
+    for (int i = 0; i < staffCount; ++i) {
+        string name = "Staff " + to_string(i + 1);
+        switch (i % staffRoleCount) {
+            case 0: staff.push_back(make_unique<Doctor>(name)); break;
+            case 1: staff.push_back(make_unique<Nurse>(name)); break;
+            case 2: staff.push_back(make_unique<Receptionist>(name)); break;
+            default: staff.push_back(make_unique<Administrator>(name)); break;
+        }
+        payroll.add(static_cast<StaffRole>(i % staffRoleCount), name, staff.back()->getSalary());
+    }
+
+    auto start = chrono::steady_clock::now();
+    {
+        ofstream legacy(path + ".legacy");
+        streambuf* console = cout.rdbuf(legacy.rdbuf());
+        for (const auto& member : staff) member->displayEarnings();
+        cout.rdbuf(console);
+    }
+    double legacySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    payroll.compute(workers);
+    double computeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ExportWriter writer(path, ExportFormat::Csv, false);
+    payroll.writeReport(writer);
+    double runSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Virtual displayEarnings() per object: " << legacySeconds << " s (" << path << ".legacy)" << endl;
+    cout << "Columnar payroll run: " << runSeconds << " s (compute " << computeSeconds * 1000 << " ms on "
+         << workers << " threads, report " << writer.byteCount() << " bytes to " << path << ")" << endl;
+    if (runSeconds > 0) cout << "Speedup: " << legacySeconds / runSeconds << "x" << endl;
+    displayPayrollTotals(payroll.totals());
+}
+
+void runPayroll(const vector<unique_ptr<Doctor>>& doctors, const vector<unique_ptr<Nurse>>& nurses,
+                const vector<unique_ptr<Receptionist>>& receptionists, const vector<unique_ptr<Administrator>>& administrators) {
+    cout << "\n--- Payroll Run ---" << endl;
+    cout << "1. Run Payroll for Current Staff" << endl;
+    cout << "2. Benchmark with Synthetic Staff" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int option = getValidIntegerInput("");
+        if (option != 1 && option != 2) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        int staffCount = option == 2 ? getValidIntegerInput("Number of staff: ") : 0;
+        if (option == 2 && staffCount < 1) {
+            throw InvalidInputException("Staff count must be positive.");
+        }
+        string path;
+        cout << "Enter payroll report path: ";
+        cin >> path;
+        unsigned workers = max(1u, thread::hardware_concurrency());
+
+        if (option == 2) {
+            benchmarkPayroll(staffCount, path, workers);
+            return;
+        }
+        PayrollRun payroll;
+        payroll.addStaff(StaffRole::Doctor, doctors);
+        payroll.addStaff(StaffRole::Nurse, nurses);
+        payroll.addStaff(StaffRole::Receptionist, receptionists);
+        payroll.addStaff(StaffRole::Administrator, administrators);
+        payroll.compute(workers);
+        ExportWriter writer(path, ExportFormat::Csv, false);
+        payroll.writeReport(writer);
+        cout << "Payroll report written to " << path << endl;
+        displayPayrollTotals(payroll.totals());
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Patient admission row: name,previous admittances,payment due,y/n,YYYY-MM-DD HH:MM
+struct AdmissionRow {
+    string_view name;
+    int previousAdmittances;
+    double paymentDue;
+    bool hasAppointment;
+    uint32_t appointmentMinutes;
+};
+
+// Splits a row into exactly count comma-separated fields
+bool splitFields(string_view line, string_view* fields, size_t count) {
+    for (size_t i = 0; i + 1 < count; ++i) {
+        size_t comma = line.find(',');
+        if (comma == string_view::npos) return false;
+        fields[i] = line.substr(0, comma);
+        line.remove_prefix(comma + 1);
+    }
+    fields[count - 1] = line;
+    return line.find(',') == string_view::npos;
+}
+
+ParseError parseAdmissionRow(string_view line, AdmissionRow& row) {
+    string_view fields[5];
+    if (!splitFields(line, fields, 5)) return ParseError::Invalid;
+    if (fields[0].empty()) return ParseError::Empty;
+    Parsed<int> admittances = parseNumber<int>(fields[1]);
+    if (!admittances.ok()) return admittances.error;
+    if (admittances.value < 0) return ParseError::OutOfRange;
+    Parsed<double> payment = parseNumber<double>(fields[2]);
+    if (!payment.ok()) return payment.error;
+    Parsed<bool> appointment = parseYesNo(fields[3]);
+    if (!appointment.ok()) return appointment.error;
+    uint32_t minutes = 0;
+    if (appointment.value) {
+        Parsed<uint32_t> when = parseDateTime(fields[4]);
+        if (!when.ok()) return when.error;
+        minutes = when.value;
+    }
+    row = { fields[0], admittances.value, payment.value, appointment.value, minutes };
+    return ParseError::None;
+}
+
+// The same row through the exception-based conversions the prompts used
+AdmissionRow parseAdmissionRowOrThrow(string_view line) {
+    string_view fields[5];
+    if (!splitFields(line, fields, 5) || fields[0].empty()) throw InvalidInputException("Malformed row.");
+    size_t used;
+    string admittances(fields[1]), payment(fields[2]);
+    int previousAdmittances = stoi(admittances, &used);
+    if (used != admittances.size() || previousAdmittances < 0) throw InvalidInputException("Invalid integer input.");
+    double paymentDue = stod(payment, &used);
+    if (used != payment.size() || !isfinite(paymentDue)) throw InvalidInputException("Invalid floating-point input.");
+    if (fields[3] != "y" && fields[3] != "n") throw InvalidInputException("Invalid input. Please enter 'y' or 'n'.");
+    bool hasAppointment = fields[3] == "y";
+    uint32_t minutes = hasAppointment ? packDateTime(string(fields[4])) : 0;
+    return { fields[0], previousAdmittances, paymentDue, hasAppointment, minutes };
+}
+
+void writeAdmissionRows(const string& path, size_t count, int badPercent) {
+    static const char* const corruptions[] = { "x", "", "12abc", "99999999999", "1.5.2", "maybe", "2025-13-01 10:00", "2025-02-30 09:00", "nan", "inf" };
+    mt19937_64 random(random_device{}());
+    ofstream out(path);
+    if (!out) throw runtime_error("Cannot create " + path + ".");
+    for (size_t i = 0; i < count; ++i) {
+        string fields[5] = { "Patient" + to_string(i), to_string(random() % 10), to_string(random() % 5000000 / 100.0), "y",
+                             formatDateTime(static_cast<uint32_t>(13000000 + random() % 600000)) };
+        if (random() % 4 != 0) fields[3] = "n";
+        if (static_cast<int>(random() % 100) < badPercent) {
+            size_t field = 1 + random() % 4;
+            if (field == 4) fields[3] = "y";
+            fields[field] = corruptions[random() % (sizeof(corruptions) / sizeof(corruptions[0]))];
+            if (field == 3 && fields[3] == "") fields[3] = "maybe";
+        }
+        out << fields[0] << ',' << fields[1] << ',' << fields[2] << ',' << fields[3] << ',' << fields[4] << '\n';
+    }
+}
+
+void benchmarkInputParsing() {
+    try {
+        string path;
+        cout << "Enter row file path: ";
+        cin >> path;
+        int count = getValidIntegerInput("Rows to generate (0 to use the file as is): ");
+        int badPercent = count > 0 ? getValidIntegerInput("Percent of malformed rows: ") : 0;
+        if (count < 0 || badPercent < 0 || badPercent > 100) {
+            throw InvalidInputException("Need a non-negative row count and a percentage from 0 to 100.");
+        }
+        if (count > 0) writeAdmissionRows(path, count, badPercent);
+
+        ifstream in(path, ios::binary);
+        if (!in) throw runtime_error("Cannot open " + path + ".");
+        string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        vector<string_view> lines;
+        for (size_t start = 0; start < text.size();) {
+            size_t end = text.find('\n', start);
+            if (end == string::npos) end = text.size();
+            lines.emplace_back(text.data() + start, end - start);
+            start = end + 1;
+        }
+
+        size_t accepted = 0, errors[5] = {};
+        double dueTotal = 0;
+        auto start = chrono::steady_clock::now();
+        for (string_view line : lines) {
+            AdmissionRow row;
+            ParseError error = parseAdmissionRow(line, row);
+            ++errors[static_cast<int>(error)];
+            if (error == ParseError::None) {
+                ++accepted;
+                dueTotal += row.paymentDue;
+            }
+        }
+        double resultSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        size_t acceptedByExceptions = 0;
+        double dueTotalByExceptions = 0;
+        start = chrono::steady_clock::now();
+        for (string_view line : lines) {
+            try {
+                AdmissionRow row = parseAdmissionRowOrThrow(line);
+                ++acceptedByExceptions;
+                dueTotalByExceptions += row.paymentDue;
+            } catch (const exception&) {
+                // stoi/stod throw invalid_argument and out_of_range; the rest throw InvalidInputException
+            }
+        }
+        double exceptionSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << lines.size() << " rows, " << accepted << " accepted, " << lines.size() - accepted << " rejected (";
+        for (int error = 1; error < 5; ++error) {
+            cout << parseErrorName(static_cast<ParseError>(error)) << " " << errors[error] << (error < 4 ? ", " : ")");
+        }
+        cout << endl;
+        cout << "Result values: " << resultSeconds << " s (" << lines.size() / resultSeconds / 1e6 << " M rows/s)" << endl;
+        cout << "Exceptions:    " << exceptionSeconds << " s (" << lines.size() / exceptionSeconds / 1e6 << " M rows/s)" << endl;
+        if (acceptedByExceptions != accepted || dueTotalByExceptions != dueTotal) {
+            cout << "Warning: the two paths disagree (" << acceptedByExceptions << " rows accepted with exceptions)." << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Times item lookups through the formulary's perfect hash against a std::map
+// of the same items, the structure the inventory used before. Names are
+// drawn from the formulary plus a few unlisted items, so misses are timed too.
+void benchmarkFormularyLookup() {
+    try {
+        int lookups = getValidIntegerInput("Number of lookups: ");
+        if (lookups < 1) {
+            throw InvalidInputException("Lookup count must be positive.");
+        }
+        map<string, int> byName;
+        vector<string> names;
+        for (const FormularyItem& item : formulary) {
+            byName.emplace(string(item.name), item.initialStock);
+            names.emplace_back(item.name);
+        }
+        for (const char* unlisted : { "Paracetamol", "Gauze", "Insulin" }) names.emplace_back(unlisted);
+
+        mt19937 random(30);
+        vector<uint32_t> order(lookups);
+        for (uint32_t& index : order) index = random() % names.size();
+
+        long long hashedTotal = 0;
+        auto start = chrono::steady_clock::now();
+        for (uint32_t index : order) {
+            int slot = formularySlot(names[index]);
+            if (slot >= 0) hashedTotal += formulary[slot].initialStock;
+        }
+        double hashedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        long long mapTotal = 0;
+        start = chrono::steady_clock::now();
+        for (uint32_t index : order) {
+            auto it = byName.find(names[index]);
+            if (it != byName.end()) mapTotal += it->second;
+        }
+        double mapSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << lookups << " lookups over " << formularySize << " formulary items and " << names.size() - formularySize
+             << " unlisted names" << endl;
+        cout << "Perfect hash: " << hashedSeconds * 1e9 / lookups << " ns per lookup" << endl;
+        cout << "std::map:     " << mapSeconds * 1e9 / lookups << " ns per lookup" << endl;
+        if (hashedTotal != mapTotal) {
+            cout << "Warning: the two lookups disagree (" << hashedTotal << " vs " << mapTotal << ")." << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Patients, appointments and stock kept in a POSIX shared-memory segment, so
+// every HMS process on the machine reads and updates one copy. The segment
+// holds no pointers: records name their strings by offset into an arena and
+// tables by offset from the segment start, so each process may map it anywhere.
+//
+// Writers hold a robust process-shared mutex. Every change is published by a
+// single store made last (a table count, an index slot or a field), so a
+// writer that dies mid-change leaves either the old state or the new one, and
+// the next locker only has to mark the mutex consistent again.
+//
+// While a segment is attached (see sharedMirror) it is the inventory: stock is
+// read from it and changed there by the amount added or removed. Patients and
+// appointments stay in the process's own tables, and each change to them is
+// copied over field by field, so a process writes only what it changed.
+constexpr uint64_t sharedMagic = 0x3353454C42415448ULL;   // "HTABLES3"
+constexpr uint32_t sharedPatientCapacity = 65536;
+constexpr uint32_t sharedAppointmentCapacity = 65536;
+constexpr uint32_t sharedStockCapacity = 1024;
+constexpr uint64_t sharedArenaBytes = 8 << 20;
+
+static_assert(atomic<uint32_t>::is_always_lock_free, "shared tables need lock-free 32-bit atomics");
+static_assert(atomic<uint64_t>::is_always_lock_free, "shared tables need lock-free 64-bit atomics");
+
+struct SharedText {
+    uint32_t offset;   // from the start of the arena
+    uint32_t length;
+};
+
+struct SharedPatient {
+    SharedText name;
+    double paymentDue;
+    uint64_t phone;
+    uint32_t previousAdmittances;
+    uint32_t removed;
+    uint64_t appointment;   // packed minutes, with sharedHasAppointment set when booked
+};
+
+constexpr uint64_t sharedHasAppointment = uint64_t(1) << 32;
+
+inline uint64_t packSharedAppointment(bool hasAppointment, uint32_t minutes) {
+    return (hasAppointment ? sharedHasAppointment : 0) | minutes;
+}
+
+struct SharedAppointment {
+    SharedText patient;
+    SharedText doctor;
+    uint32_t minutes;
+    uint32_t cancelled;
+};
+
+struct SharedStock {
+    SharedText name;
+    int64_t quantity;
+};
+
+struct SharedTable {
+    uint64_t offset;             // records, from the start of the segment
+    uint64_t indexOffset;        // open-addressed slots holding record + 1, or 0
+    uint32_t capacity;
+    uint32_t indexMask;
+    atomic<uint32_t> count;      // records [0, count) are committed
+};
+
+struct SharedHeader {
+    uint64_t magic;
+    atomic<uint32_t> ready;
+    pthread_mutex_t lock;
+    SharedTable patients;
+    SharedTable appointments;
+    SharedTable stock;
+    uint64_t arenaOffset;
+    uint64_t arenaCapacity;
+    atomic<uint64_t> arenaUsed;
+    uint64_t recoveries;
+    uint64_t updates;
+};
+
+class SharedTables {
+private:
+    int fd;
+    char* base;
+    size_t bytes;
+    SharedHeader* header;
+    bool creator;
+
+    // Takes the segment mutex, repairing it if the last owner died holding it
+    class Lock {
+    private:
+        pthread_mutex_t& mutex;
+
+    public:
+        Lock(SharedHeader& header) : mutex(header.lock) {
+            int result = pthread_mutex_lock(&mutex);
+            if (result == EOWNERDEAD) {
+                pthread_mutex_consistent(&mutex);
+                ++header.recoveries;
+            } else if (result != 0) {
+                throw runtime_error(string("Shared segment lock failed: ") + strerror(result));
+            }
+        }
+        ~Lock() { pthread_mutex_unlock(&mutex); }
+
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+    };
+
+    static uint64_t align(uint64_t offset) {
+        return (offset + 63) & ~uint64_t(63);
+    }
+
+    static uint32_t indexSlots(uint32_t capacity) {
+        uint32_t slots = 1;
+        while (slots < 2 * capacity) slots <<= 1;
+        return slots;
+    }
+
+    static uint64_t hashName(string_view name) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (char c : name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Appointments are indexed by the whole (patient, doctor, time) key
+    static uint64_t hashAppointment(string_view patient, string_view doctor, uint32_t minutes) {
+        return (hashName(patient) * 31 + hashName(doctor)) * 1099511628211ULL ^ minutes;
+    }
+
+    static bool live(const SharedPatient& patient) {
+        return patient.removed == 0;
+    }
+
+    static bool live(const SharedStock&) {
+        return true;
+    }
+
+    static uint64_t layoutTable(SharedTable& table, uint64_t offset, uint32_t capacity, size_t recordSize, bool indexed) {
+        table.offset = align(offset);
+        table.capacity = capacity;
+        table.count.store(0, memory_order_relaxed);
+        offset = table.offset + uint64_t(capacity) * recordSize;
+        table.indexMask = indexed ? indexSlots(capacity) - 1 : 0;
+        table.indexOffset = indexed ? align(offset) : 0;
+        return indexed ? table.indexOffset + uint64_t(table.indexMask + 1) * sizeof(uint32_t) : offset;
+    }
+
+    static uint64_t segmentBytes() {
+        SharedHeader layout;
+        uint64_t offset = sizeof(SharedHeader);
+        offset = layoutTable(layout.patients, offset, sharedPatientCapacity, sizeof(SharedPatient), true);
+        offset = layoutTable(layout.appointments, offset, sharedAppointmentCapacity, sizeof(SharedAppointment), true);
+        offset = layoutTable(layout.stock, offset, sharedStockCapacity, sizeof(SharedStock), true);
+        return align(offset) + sharedArenaBytes;
+    }
+
+    template <typename Record>
+    Record* records(const SharedTable& table) const {
+        return reinterpret_cast<Record*>(base + table.offset);
+    }
+
+    uint32_t* slots(const SharedTable& table) const {
+        return reinterpret_cast<uint32_t*>(base + table.indexOffset);
+    }
+
+    string_view text(SharedText t) const {
+        return string_view(base + header->arenaOffset + t.offset, t.length);
+    }
+
+    // Copies text past the arena watermark; it becomes reachable only once the
+    // record naming it is committed.
+    SharedText store(string_view value) {
+        uint64_t used = header->arenaUsed.load(memory_order_relaxed);
+        if (used + value.size() > header->arenaCapacity) {
+            throw runtime_error("Shared segment string arena is full.");
+        }
+        memcpy(base + header->arenaOffset + used, value.data(), value.size());
+        header->arenaUsed.store(used + value.size(), memory_order_release);
+        return { static_cast<uint32_t>(used), static_cast<uint32_t>(value.size()) };
+    }
+
+    template <typename Record>
+    Record* find(const SharedTable& table, string_view name) const {
+        uint32_t count = table.count.load(memory_order_acquire);
+        const uint32_t* index = slots(table);
+        for (uint64_t slot = hashName(name) & table.indexMask; index[slot] != 0; slot = (slot + 1) & table.indexMask) {
+            uint32_t record = index[slot] - 1;
+            // A slot written by a writer that died before committing names an
+            // uncommitted record; skip it.
+            if (record < count && live(records<Record>(table)[record]) && text(records<Record>(table)[record].name) == name) {
+                return &records<Record>(table)[record];
+            }
+        }
+        return nullptr;
+    }
+
+    SharedAppointment* findAppointment(string_view patient, string_view doctor, uint32_t minutes) const {
+        const SharedTable& table = header->appointments;
+        uint32_t count = table.count.load(memory_order_acquire);
+        const uint32_t* index = slots(table);
+        SharedAppointment* appointments = records<SharedAppointment>(table);
+        for (uint64_t slot = hashAppointment(patient, doctor, minutes) & table.indexMask; index[slot] != 0;
+             slot = (slot + 1) & table.indexMask) {
+            uint32_t record = index[slot] - 1;
+            if (record < count && appointments[record].cancelled == 0 && appointments[record].minutes == minutes &&
+                text(appointments[record].patient) == patient && text(appointments[record].doctor) == doctor) {
+                return &appointments[record];
+            }
+        }
+        return nullptr;
+    }
+
+    // Fills the next record, indexes it under hash, then commits it by
+    // bumping the count
+    template <typename Record>
+    void append(SharedTable& table, const Record& record, uint64_t hash) {
+        uint32_t count = table.count.load(memory_order_relaxed);
+        if (count == table.capacity) throw runtime_error("Shared table is full.");
+        records<Record>(table)[count] = record;
+        if (table.indexOffset != 0) {
+            uint32_t* index = slots(table);
+            uint64_t position = hash & table.indexMask;
+            while (index[position] != 0 && index[position] - 1 < count) position = (position + 1) & table.indexMask;
+            __atomic_store_n(&index[position], count + 1, __ATOMIC_RELEASE);
+        }
+        table.count.store(count + 1, memory_order_release);
+    }
+
+    void initialise() {
+        header->magic = sharedMagic;
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+
+        uint64_t offset = sizeof(SharedHeader);
+        offset = layoutTable(header->patients, offset, sharedPatientCapacity, sizeof(SharedPatient), true);
+        offset = layoutTable(header->appointments, offset, sharedAppointmentCapacity, sizeof(SharedAppointment), true);
+        offset = layoutTable(header->stock, offset, sharedStockCapacity, sizeof(SharedStock), true);
+        header->arenaOffset = align(offset);
+        header->arenaCapacity = sharedArenaBytes;
+        header->arenaUsed.store(0, memory_order_relaxed);
+        header->recoveries = 0;
+        header->updates = 0;
+
+        for (const FormularyItem& item : formulary) {
+            SharedText name = store(item.name);
+            append(header->stock, SharedStock{ name, item.initialStock }, hashName(item.name));
+        }
+        header->ready.store(1, memory_order_release);
+    }
+
+public:
+    // Creates the named segment, or attaches to it if another process got there first
+    SharedTables(const string& name) : fd(-1), base(nullptr), bytes(segmentBytes()), header(nullptr), creator(false) {
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            creator = true;
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                int error = errno;
+                close(fd);
+                shm_unlink(name.c_str());
+                throw runtime_error(string("Cannot size shared segment: ") + strerror(error));
+            }
+        } else if (errno == EEXIST) {
+            fd = shm_open(name.c_str(), O_RDWR, 0600);
+        }
+        if (fd < 0) throw runtime_error("Cannot open shared segment " + name + ": " + strerror(errno));
+
+        struct stat info;
+        for (int attempt = 0; !creator && fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < bytes; ++attempt) {
+            if (attempt == 100) {
+                close(fd);
+                throw runtime_error(name + " is not an HMS shared segment.");
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+
+        void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw runtime_error(string("Cannot map shared segment: ") + strerror(error));
+        }
+        base = static_cast<char*>(mapping);
+        header = reinterpret_cast<SharedHeader*>(base);
+
+        if (creator) {
+            initialise();
+            return;
+        }
+        // The creator publishes ready last; give it a moment if it is still laying out
+        for (int attempt = 0; header->ready.load(memory_order_acquire) == 0; ++attempt) {
+            if (attempt == 100) {
+                munmap(base, bytes);
+                close(fd);
+                throw runtime_error(name + " was never initialised; remove it and create it again.");
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        if (header->magic != sharedMagic) {
+            munmap(base, bytes);
+            close(fd);
+            throw runtime_error(name + " is not an HMS shared segment.");
+        }
+    }
+
+    ~SharedTables() {
+        munmap(base, bytes);
+        close(fd);
+    }
+
+    SharedTables(const SharedTables&) = delete;
+    SharedTables& operator=(const SharedTables&) = delete;
+
+    static void remove(const string& name) {
+        if (shm_unlink(name.c_str()) != 0) {
+            throw runtime_error("Cannot remove shared segment " + name + ": " + strerror(errno));
+        }
+    }
+
+    bool created() const {
+        return creator;
+    }
+
+    // False when a patient of that name is already shared
+    bool addPatient(const Patient& patient) {
+        Lock lock(*header);
+        string name = patient.getName();
+        if (find<SharedPatient>(header->patients, name)) return false;
+        SharedPatient record{ store(name), patient.getPaymentDue(), patient.getPhoneNumber(),
+                              static_cast<uint32_t>(patient.getPreviousAdmittances()), 0,
+                              packSharedAppointment(patient.hasAppointment(), patient.getAppointmentMinutes()) };
+        append(header->patients, record, hashName(name));
+        ++header->updates;
+        return true;
+    }
+
+    // Date and flag go out in one store, so readers never see half of a change
+    bool setAppointment(const string& name, bool hasAppointment, uint32_t minutes) {
+        Lock lock(*header);
+        SharedPatient* patient = find<SharedPatient>(header->patients, name);
+        if (!patient) return false;
+        __atomic_store_n(&patient->appointment, packSharedAppointment(hasAppointment, minutes), __ATOMIC_RELEASE);
+        ++header->updates;
+        return true;
+    }
+
+    bool removePatient(const string& name) {
+        Lock lock(*header);
+        SharedPatient* shared = find<SharedPatient>(header->patients, name);
+        if (!shared) return false;
+        shared->removed = 1;
+        ++header->updates;
+        return true;
+    }
+
+    // False when the same appointment is already shared, found through the
+    // (patient, doctor, time) index rather than a scan of the table
+    bool addAppointment(const Appointment& appointment) {
+        Lock lock(*header);
+        uint32_t minutes = packDateTime(appointment.getDateAndTime());
+        if (findAppointment(appointment.getPatientName(), appointment.getDoctorName(), minutes)) return false;
+        SharedText patient = store(appointment.getPatientName());
+        SharedText doctor = store(appointment.getDoctorName());
+        append(header->appointments, SharedAppointment{ patient, doctor, minutes, 0 },
+               hashAppointment(appointment.getPatientName(), appointment.getDoctorName(), minutes));
+        ++header->updates;
+        return true;
+    }
+
+    bool cancelAppointment(const Appointment& appointment) {
+        Lock lock(*header);
+        Parsed<uint32_t> minutes = parseDateTime(appointment.getDateAndTime());
+        if (!minutes.ok()) return false;
+        SharedAppointment* shared = findAppointment(appointment.getPatientName(), appointment.getDoctorName(), minutes.value);
+        if (!shared) return false;
+        shared->cancelled = 1;
+        ++header->updates;
+        return true;
+    }
+
+    bool setPaymentDue(const string& name, double payment) {
+        Lock lock(*header);
+        SharedPatient* patient = find<SharedPatient>(header->patients, name);
+        if (!patient) return false;
+        patient->paymentDue = payment;
+        ++header->updates;
+        return true;
+    }
+
+    // Both return the quantity the change leaves
+    int64_t addStock(const string& itemName, int quantity) {
+        Lock lock(*header);
+        SharedStock* item = find<SharedStock>(header->stock, itemName);
+        if (item) {
+            item->quantity += quantity;
+        } else {
+            SharedText name = store(itemName);
+            append(header->stock, SharedStock{ name, quantity }, hashName(itemName));
+            item = find<SharedStock>(header->stock, itemName);
+        }
+        ++header->updates;
+        return item->quantity;
+    }
+
+    int64_t removeStock(const string& itemName, int quantity) {
+        Lock lock(*header);
+        SharedStock* item = find<SharedStock>(header->stock, itemName);
+        if (!item || item->quantity < quantity) {
+            throw InsufficientInventoryException("Insufficient quantity of " + itemName + " in inventory.");
+        }
+        item->quantity -= quantity;
+        ++header->updates;
+        return item->quantity;
+    }
+
+    int64_t quantityOf(const string& itemName) {
+        Lock lock(*header);
+        const SharedStock* item = find<SharedStock>(header->stock, itemName);
+        return item ? item->quantity : 0;
+    }
+
+    // Visitors run under the segment lock: (name, record)
+    template <typename Visitor>
+    void forEachPatient(Visitor visit) {
+        Lock lock(*header);
+        const SharedPatient* patients = records<SharedPatient>(header->patients);
+        for (uint32_t i = 0, count = header->patients.count.load(memory_order_acquire); i < count; ++i) {
+            if (live(patients[i])) visit(text(patients[i].name), patients[i]);
+        }
+    }
+
+    // (patient, doctor, packed minutes)
+    template <typename Visitor>
+    void forEachAppointment(Visitor visit) {
+        Lock lock(*header);
+        const SharedAppointment* appointments = records<SharedAppointment>(header->appointments);
+        for (uint32_t i = 0, count = header->appointments.count.load(memory_order_acquire); i < count; ++i) {
+            if (appointments[i].cancelled == 0) {
+                visit(text(appointments[i].patient), text(appointments[i].doctor), appointments[i].minutes);
+            }
+        }
+    }
+
+    // (name, quantity)
+    template <typename Visitor>
+    void forEachStock(Visitor visit) {
+        Lock lock(*header);
+        const SharedStock* stock = records<SharedStock>(header->stock);
+        for (uint32_t i = 0, count = header->stock.count.load(memory_order_acquire); i < count; ++i) {
+            visit(text(stock[i].name), stock[i].quantity);
+        }
+    }
+
+    void displayStatistics() {
+        Lock lock(*header);
+        cout << "Segment size: " << bytes / 1024 << " KiB" << endl;
+        cout << "Patients: " << header->patients.count.load() << " of " << header->patients.capacity << endl;
+        cout << "Appointments: " << header->appointments.count.load() << " of " << header->appointments.capacity << endl;
+        cout << "Stock items: " << header->stock.count.load() << " of " << header->stock.capacity << endl;
+        cout << "String arena: " << header->arenaUsed.load() << " of " << header->arenaCapacity << " bytes" << endl;
+        cout << "Updates: " << header->updates << endl;
+        cout << "Lock recoveries after a crashed writer: " << header->recoveries << endl;
     }
 };
 
-void handlePatient(const vector<unique_ptr<Patient>>& patients) {
-    cout << "Welcome, Patient! You can check your details." << endl;
-    string inputName;
-    cout << "Enter your name: ";
-    cin >> inputName;
-    auto it = find_if(patients.begin(), patients.end(),
-                        [&](const unique_ptr<Patient>& p){ return p->matchesName(inputName); });
+// Set while a shared segment is attached; the menus' mutations are copied to it
+SharedTables* sharedMirror = nullptr;
 
-    if (it != patients.end()) {
-        cout << "Patient details found:" << endl;
-        displayDetails(**it);
-        int choice;
-        cout << "What would you like to know?" << endl;
-        cout << "1. Dues" << endl;
-        cout << "2. Appointments" << endl;
-        cout << "Enter your choice (1-2): ";
-        try {
-            choice = getValidIntegerInput("");
-            switch (choice) {
-                case 1:
-                    (*it)->displayDues();
-                    break;
-                case 2:
-                    (*it)->displayAppointments();
-                    break;
-                default:
-                    cout << "Invalid choice!" << endl;
+// A segment that cannot take a change (full, or a date it cannot pack) is
+// reported; the in-process change stands either way
+template <typename Update>
+void mirrorToSegment(Update update) {
+    if (!sharedMirror) return;
+    try {
+        update(*sharedMirror);
+    } catch (const runtime_error& e) {
+        cerr << "Shared segment not updated: " << e.what() << endl;
+    }
+}
+
+void sharePatient(const Patient& patient) {
+    mirrorToSegment([&](SharedTables& tables) { tables.addPatient(patient); });
+}
+
+void sharePaymentDue(const Patient& patient) {
+    mirrorToSegment([&](SharedTables& tables) { tables.setPaymentDue(patient.getName(), patient.getPaymentDue()); });
+}
+
+void shareAppointmentDate(const Patient& patient) {
+    mirrorToSegment([&](SharedTables& tables) {
+        tables.setAppointment(patient.getName(), patient.hasAppointment(), patient.getAppointmentMinutes());
+    });
+}
+
+void unsharePatient(const string& name) {
+    mirrorToSegment([&](SharedTables& tables) { tables.removePatient(name); });
+}
+
+void shareAppointment(const Appointment& appointment) {
+    mirrorToSegment([&](SharedTables& tables) { tables.addAppointment(appointment); });
+}
+
+void unshareAppointment(const Appointment& appointment) {
+    mirrorToSegment([&](SharedTables& tables) { tables.cancelAppointment(appointment); });
+}
+
+// Stock changes are not mirrored but made in the segment, so its errors
+// (not enough stock, a full table) reach the caller
+bool sharedStockAdd(const string& itemName, int quantity, int64_t& level) {
+    if (!sharedMirror) return false;
+    level = sharedMirror->addStock(itemName, quantity);
+    return true;
+}
+
+bool sharedStockRemove(const string& itemName, int quantity, int64_t& level) {
+    if (!sharedMirror) return false;
+    level = sharedMirror->removeStock(itemName, quantity);
+    return true;
+}
+
+bool sharedStockLevel(const string& itemName, int64_t& level) {
+    if (!sharedMirror) return false;
+    level = sharedMirror->quantityOf(itemName);
+    return true;
+}
+
+// The segment lists the formulary first, in catalogue order; the rest are
+// sorted by name to match Inventory::forEachItem
+bool sharedStockLevels(vector<pair<string, int64_t>>& levels) {
+    if (!sharedMirror) return false;
+    sharedMirror->forEachStock([&](string_view itemName, int64_t quantity) {
+        levels.emplace_back(string(itemName), quantity);
+    });
+    sort(levels.begin() + min(levels.size(), formularySize), levels.end());
+    return true;
+}
+
+// Forks writers that each move one unit of stock out and back in, so the
+// quantity must come back unchanged. Optionally one more process dies while
+// holding the segment lock, which the survivors must recover from.
+void stressSharedTables(SharedTables& tables, int processes, int operations, bool crashWriter) {
+    const string itemName = "Syringes";
+    int64_t before = tables.quantityOf(itemName);
+    cout.flush();
+    cerr.flush();
+
+    auto start = chrono::steady_clock::now();
+    vector<pid_t> children;
+    if (crashWriter) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            tables.forEachStock([](string_view, int64_t) { _exit(0); });
+            _exit(1);
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    for (int p = 0; p < processes; ++p) {
+        pid_t pid = fork();
+        if (pid < 0) break;
+        if (pid == 0) {
+            int status = 0;
+            try {
+                for (int i = 0; i < operations; ++i) {
+                    tables.removeStock(itemName, 1);
+                    tables.addStock(itemName, 1);
+                }
+            } catch (const runtime_error&) {
+                status = 1;
             }
-        } catch (const InvalidInputException& e) {
-            cerr << "Error: " << e.what() << endl;
+            _exit(status);
         }
-    } else {
-        cout << "No records found for " << inputName << "!" << endl;
+        children.push_back(pid);
+    }
+
+    int failed = 0;
+    for (pid_t child : children) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failed;
     }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long updates = 2L * processes * operations;
+    int64_t after = tables.quantityOf(itemName);
+
+    cout << children.size() << " processes made " << updates << " updates in " << seconds << " s";
+    if (seconds > 0) cout << " (" << updates / seconds << " updates/s)";
+    cout << endl;
+    if (failed > 0) cout << failed << " writer processes failed." << endl;
+    cout << itemName << ": " << before << " before, " << after << " after"
+         << (before == after ? " (consistent)" : " (INCONSISTENT)") << endl;
 }
 
-void handleNurse(const vector<unique_ptr<Patient>>& patients, const Inventory& inventory) {
-    cout << "Welcome, Nurse!" << endl;
-    string nurseName;
-    cout << "Enter Nurse's name: ";
-    cin >> nurseName;
-    Nurse nurse(nurseName);
+void manageSharedTables(unique_ptr<SharedTables>& tables, string& segmentName, const vector<unique_ptr<Patient>>& patients,
+                        const AppointmentBook& appointments) {
+    cout << "\n--- Shared Tables ---" << endl;
+    cout << "1. Attach or Create Segment" << endl;
+    cout << "2. Publish Current Patients and Appointments" << endl;
+    cout << "3. Display Shared Patients" << endl;
+    cout << "4. Display Shared Appointments" << endl;
+    cout << "5. Update Shared Payment Due" << endl;
+    cout << "6. Add Shared Stock" << endl;
+    cout << "7. Remove Shared Stock" << endl;
+    cout << "8. Display Shared Inventory" << endl;
+    cout << "9. Multi-Process Stress Test" << endl;
+    cout << "10. Segment Statistics" << endl;
+    cout << "11. Detach and Remove Segment" << endl;
+    cout << "Enter your choice: ";
 
-    int option;
-    cout << "What would you like to see?" << endl;
-    cout << "1. Patient Details" << endl;
-    cout << "2. Inventory Records" << endl;
-    cout << "3. Earnings" << endl;
-    cout << "Enter your choice (1-3): ";
     try {
-        option = getValidIntegerInput("");
+        int option = getValidIntegerInput("");
+        if (option < 1 || option > 11) {
+            cout << "Invalid choice!" << endl;
+            return;
+        }
+        if (option == 1) {
+            string name;
+            cout << "Enter segment name: ";
+            cin >> name;
+            if (name[0] != '/') name = "/" + name;
+            sharedMirror = nullptr;
+            tables.reset();
+            tables = make_unique<SharedTables>(name);
+            sharedMirror = tables.get();
+            segmentName = name;
+            cout << (tables->created() ? "Created" : "Attached to") << " shared segment " << name << "." << endl;
+            return;
+        }
+        if (!tables) {
+            cout << "No shared segment is attached." << endl;
+            return;
+        }
+
         switch (option) {
-            case 1:
-                nurse.displayPatientDetails(patients);
+            case 2: {
+                size_t addedPatients = 0, addedAppointments = 0;
+                for (const auto& patient : patients) {
+                    if (tables->addPatient(*patient)) ++addedPatients;
+                }
+                for (const auto& appointment : appointments.all()) {
+                    if (tables->addAppointment(*appointment)) ++addedAppointments;
+                }
+                cout << "Published " << addedPatients << " patients and " << addedAppointments
+                     << " appointments; the rest were already shared." << endl;
                 break;
-            case 2:
-                nurse.displayInventory(inventory);
+            }
+            case 3: {
+                tables->forEachPatient([](string_view name, const SharedPatient& patient) {
+                    cout << name << "\t" << formatPhoneNumber(patient.phone) << "\t" << patient.previousAdmittances
+                         << " admittances\t" << patient.paymentDue << " due";
+                    uint64_t appointment = __atomic_load_n(&patient.appointment, __ATOMIC_ACQUIRE);
+                    if (appointment & sharedHasAppointment) cout << "\t" << formatDateTime(static_cast<uint32_t>(appointment));
+                    cout << endl;
+                });
                 break;
-            case 3:
-                nurse.displayEarnings();
+            }
+            case 4: {
+                tables->forEachAppointment([](string_view patient, string_view doctor, uint32_t minutes) {
+                    cout << formatDateTime(minutes) << "\t" << patient << "\t" << doctor << endl;
+                });
+                break;
+            }
+            case 5: {
+                string name;
+                cout << "Enter the name of the patient: ";
+                cin >> name;
+                double payment = getValidDoubleInput("Enter new payment due: ");
+                Patient::checkPaymentDue(payment);
+                if (tables->setPaymentDue(name, payment)) {
+                    cout << "Payment due updated." << endl;
+                } else {
+                    cout << "Patient with name '" << name << "' not found." << endl;
+                }
+                break;
+            }
+            case 6:
+            case 7: {
+                string itemName;
+                cout << "Enter item name: ";
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                getline(cin, itemName);
+                int quantity = getValidIntegerInput("Enter quantity: ");
+                if (quantity < 1) {
+                    throw InvalidInputException("Quantity must be positive.");
+                }
+                if (option == 6) {
+                    tables->addStock(itemName, quantity);
+                } else {
+                    tables->removeStock(itemName, quantity);
+                }
+                cout << itemName << ": " << tables->quantityOf(itemName) << " in quantity" << endl;
+                break;
+            }
+            case 8: {
+                cout << "Shared Inventory Records:" << endl;
+                tables->forEachStock([](string_view itemName, int64_t quantity) {
+                    cout << itemName << ": " << quantity << " in quantity" << endl;
+                });
+                break;
+            }
+            case 9: {
+                int processes = getValidIntegerInput("Number of writer processes: ");
+                int operations = getValidIntegerInput("Updates per process: ");
+                if (processes < 1 || operations < 1) {
+                    throw InvalidInputException("Counts must be positive.");
+                }
+                bool crashWriter = getYesNoInput("Also kill a process while it holds the lock?");
+                stressSharedTables(*tables, processes, operations, crashWriter);
+                break;
+            }
+            case 10:
+                tables->displayStatistics();
+                break;
+            case 11:
+                sharedMirror = nullptr;
+                tables.reset();
+                SharedTables::remove(segmentName);
+                cout << "Removed shared segment " << segmentName << "." << endl;
                 break;
-            default:
-                cout << "Invalid choice!" << endl;
         }
     } catch (const InvalidInputException& e) {
         cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
     }
 }
 
-void handleDoctor(const vector<unique_ptr<Patient>>& patients, const Inventory& inventory) {
-    cout << "Welcome, Doctor!" << endl;
-    string doctorName;
-    cout << "Enter Doctor's name: ";
-    cin >> doctorName;
-    Doctor doctor(doctorName);
+double percentile(const vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(ceil(fraction * sorted.size()));
+    return sorted[min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// Decodes an event log written by MutationLog
+void displayMutationLog(const string& path) {
+    ifstream in(path, ios::binary);
+    uint64_t magic = 0;
+    if (!in.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != mutationLogMagic) {
+        throw runtime_error(path + " is not an event log.");
+    }
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+    size_t position = 0, events = 0;
+    while (position + 3 <= data.size()) {
+        uint16_t size;
+        memcpy(&size, &data[position], sizeof(size));
+        if (size < 12 || position + size > data.size()) throw runtime_error(path + " is truncated.");
+        const char* field = &data[position] + 3;
+        const char* recordEnd = &data[position] + size;
+        auto need = [&](size_t bytes) {
+            if (static_cast<size_t>(recordEnd - field) < bytes) {
+                throw runtime_error(path + " has a malformed event at byte " + to_string(sizeof(magic) + position) + ".");
+            }
+        };
+        auto take = [&](auto& value) {
+            need(sizeof(value));
+            memcpy(&value, field, sizeof(value));
+            field += sizeof(value);
+        };
+        auto takeText = [&]() {
+            need(1);
+            uint8_t length = static_cast<uint8_t>(*field++);
+            need(length);
+            string text(field, length);
+            field += length;
+            return text;
+        };
+
+        uint64_t micros;
+        take(micros);
+        time_t seconds = static_cast<time_t>(micros / 1000000);
+        char stamp[20];
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+        cout << stamp << "\t";
+
+        switch (static_cast<MutationType>(data[position + 2])) {
+            case MutationType::PatientAdded: {
+                string name = takeText();
+                uint64_t phone;
+                uint32_t admittances, minutes;
+                double paymentDue;
+                take(phone);
+                take(admittances);
+                take(paymentDue);
+                take(minutes);
+                cout << "patient added\t" << name << "\t" << formatPhoneNumber(phone) << "\t" << admittances
+                     << " admittances\t" << paymentDue << " due";
+                if (minutes != 0) cout << "\t" << formatDateTime(minutes);
+                break;
+            }
+            case MutationType::AppointmentAdded: {
+                string patient = takeText();
+                string doctor = takeText();
+                uint32_t minutes;
+                take(minutes);
+                cout << "appointment added\t" << formatDateTime(minutes) << "\t" << patient << "\t" << doctor;
+                break;
+            }
+            case MutationType::StockRemoved: {
+                string item = takeText();
+                int32_t quantity, remaining;
+                take(quantity);
+                take(remaining);
+                cout << "stock removed\t" << item << "\t" << quantity << " taken, " << remaining << " left";
+                break;
+            }
+            default:
+                cout << "unknown event";
+        }
+        cout << endl;
+        position += size;
+        ++events;
+    }
+    cout << events << " events." << endl;
+}
+
+void displayMutationLogStatistics(const MutationLog& log) {
+    cout << "Ring size: " << log.ringBytes() << " bytes" << endl;
+    cout << "Events emitted: " << log.eventsEmitted << " (" << log.bytesEmitted << " bytes)" << endl;
+    cout << "Events written: " << log.eventsWritten.load() << " in " << log.batches.load() << " batches" << endl;
+    if (log.batchesDropped.load() > 0) {
+        cout << "Events dropped after a write error: " << log.eventsDropped.load() << " (" << log.bytesDropped.load()
+             << " bytes in " << log.batchesDropped.load() << " batches)" << endl;
+    }
+    cout << "Pending in ring: " << log.pendingBytes() << " bytes" << endl;
+    cout << "Peak ring occupancy: " << log.peakOccupancy << " bytes" << endl;
+    cout << "Producer stalls on a full ring: " << log.stalls << " (" << log.stallNanoseconds / 1e6 << " ms waiting)" << endl;
+    if (log.error() != 0) cout << "Writer failed: " << strerror(log.error()) << endl;
+}
+
+// Times stock removals on a scratch inventory with no event log, with the
+// background writer, and with every event written inline
+void benchmarkMutationLatency(const string& path, int requests) {
+    const char* modes[] = { "no event log", "ring + background writer", "inline write per event" };
+    MutationLog* active = mutationLog;
+    SharedTables* mirror = sharedMirror;
+    sharedMirror = nullptr;
+    for (int mode = 0; mode < 3; ++mode) {
+        Inventory scratch;
+        scratch.addItem("Syringes", requests);
+        unique_ptr<MutationLog> log;
+        if (mode > 0) log = make_unique<MutationLog>(path, 64 * 1024, mode == 2);
+        mutationLog = log.get();
+
+        vector<double> latencies;
+        latencies.reserve(requests);
+        auto begin = chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i) {
+            auto start = chrono::steady_clock::now();
+            scratch.removeItem("Syringes", 1);
+            latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        mutationLog = active;
+        sort(latencies.begin(), latencies.end());
+
+        cout << fixed << setprecision(2);
+        cout << modes[mode] << ": p50=" << percentile(latencies, 0.50) << " us p99=" << percentile(latencies, 0.99)
+             << " us p999=" << percentile(latencies, 0.999) << " us max=" << latencies.back() << " us, "
+             << setprecision(0) << requests / seconds << " requests/s";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+        if (log) cout << ", " << log->stalls << " stalls";
+        cout << endl;
+    }
+    sharedMirror = mirror;
+}
+
+void manageMutationLog(unique_ptr<MutationLog>& log) {
+    cout << "\n--- Mutation Event Log ---" << endl;
+    cout << "1. Start Logging to File" << endl;
+    cout << "2. Stop Logging" << endl;
+    cout << "3. Logging Statistics" << endl;
+    cout << "4. Display Event Log File" << endl;
+    cout << "5. Request Latency Benchmark" << endl;
+    cout << "Enter your choice: ";
 
-    int option;
-    cout << "What would you like to see?" << endl;
-    cout << "1. Patient Details" << endl;
-    cout << "2. Inventory Records" << endl;
-    cout << "3. Earnings" << endl;
-    cout << "Enter your choice (1-3): ";
     try {
-        option = getValidIntegerInput("");
+        int option = getValidIntegerInput("");
         switch (option) {
-            case 1:
-                doctor.displayPatientDetails(patients);
+            case 1: {
+                string path;
+                cout << "Enter event log file path: ";
+                cin >> path;
+                int kilobytes = getValidIntegerInput("Ring size in KiB: ");
+                if (kilobytes < 1) {
+                    throw InvalidInputException("Ring size must be positive.");
+                }
+                mutationLog = nullptr;
+                log.reset();
+                log = make_unique<MutationLog>(path, static_cast<size_t>(kilobytes) * 1024);
+                mutationLog = log.get();
+                cout << "Logging patient, appointment and stock mutations to " << path << "." << endl;
                 break;
+            }
             case 2:
-                doctor.displayInventory(inventory);
+                if (!log) {
+                    cout << "Event logging is not running." << endl;
+                    break;
+                }
+                mutationLog = nullptr;
+                log->stop();
+                if (log->eventsDropped.load() > 0) {
+                    cout << "Event log closed; " << log->eventsDropped.load() << " events were lost after a write error: "
+                         << strerror(log->error()) << "." << endl;
+                } else {
+                    cout << "Event log flushed and closed." << endl;
+                }
+                log.reset();
                 break;
             case 3:
-                doctor.displayEarnings();
+                if (!log) {
+                    cout << "Event logging is not running." << endl;
+                    break;
+                }
+                displayMutationLogStatistics(*log);
+                break;
+            case 4: {
+                string path;
+                cout << "Enter event log file path: ";
+                cin >> path;
+                displayMutationLog(path);
+                break;
+            }
+            case 5: {
+                string path;
+                cout << "Enter scratch log file path: ";
+                cin >> path;
+                int requests = getValidIntegerInput("Number of requests: ");
+                if (requests < 1) {
+                    throw InvalidInputException("Number of requests must be positive.");
+                }
+                benchmarkMutationLatency(path, requests);
                 break;
+            }
             default:
                 cout << "Invalid choice!" << endl;
         }
     } catch (const InvalidInputException& e) {
         cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
     }
 }
 
-void handleReceptionist(const vector<unique_ptr<Appointment>>& appointments, const vector<unique_ptr<Patient>>& patients, const vector<unique_ptr<Doctor>>& doctors) {
-    cout << "Welcome, Receptionist!" << endl;
-    string receptionistName;
-    cout << "Enter Receptionist's name: ";
-    cin >> receptionistName;
-    Receptionist receptionist(receptionistName);
+void displayStockForecast(const Inventory& inventory) {
+    cout << "\n--- Stockout Forecast ---" << endl;
+    cout << "1. Catalogue Forecast" << endl;
+    cout << "2. Item Consumption, Last 24 Hours" << endl;
+    cout << "Enter your choice: ";
 
-    int option;
-    cout << "What would you like to do?" << endl;
-    cout << "1. Manage Appointments" << endl;
-    cout << "2. View Patient Details" << endl;
-    cout << "3. View Earnings" << endl;
-    cout << "Enter your choice (1-3): ";
     try {
-        option = getValidIntegerInput("");
+        int option = getValidIntegerInput("");
+        if (option == 1) {
+            int horizon = getValidIntegerInput("Show items running out within how many days (0 for all): ");
+            if (horizon < 0) {
+                throw InvalidInputException("Days cannot be negative.");
+            }
+            auto start = chrono::steady_clock::now();
+            vector<StockForecast> forecasts = inventory.forecast();
+            double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            sort(forecasts.begin(), forecasts.end(), [](const StockForecast& a, const StockForecast& b) {
+                return a.daysLeft < b.daysLeft;
+            });
+
+            cout << fixed << setprecision(1);
+            cout << left << setw(24) << "Item" << right << setw(10) << "In stock" << setw(12) << "Used/day"
+                 << setw(12) << "Days left" << endl;
+            size_t shown = 0;
+            for (const StockForecast& item : forecasts) {
+                if (horizon > 0 && item.daysLeft > horizon) continue;
+                cout << left << setw(24) << item.itemName << right << setw(10) << item.quantity
+                     << setw(12) << item.dailyRate;
+                if (isinf(item.daysLeft)) {
+                    cout << setw(12) << "-" << endl;
+                } else {
+                    cout << setw(12) << item.daysLeft << endl;
+                }
+                ++shown;
+            }
+            cout << shown << " of " << forecasts.size() << " items, forecast in " << micros << " us." << endl;
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        } else if (option == 2) {
+            string itemName;
+            cout << "Enter item name: ";
+            cin.ignore();
+            getline(cin, itemName);
+            vector<uint32_t> used = inventory.recentConsumption(itemName, 24);
+            for (size_t i = 0; i < used.size(); ++i) {
+                cout << setw(3) << static_cast<int>(i) - static_cast<int>(used.size()) + 1 << "h: " << used[i] << endl;
+            }
+        } else {
+            cout << "Invalid choice!" << endl;
+        }
+    } catch (const InvalidInputException& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+}
+
+// Writes and discards, so benchmarks time rendering rather than the terminal
+class DiscardBuffer : public streambuf {
+protected:
+    int overflow(int c) override {
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char*, streamsize count) override {
+        return count;
+    }
+};
+
+// Lists synthetic patients repeatedly, rendering each time and then through
+// a view cache with the given budget
+void benchmarkPatientViews(int count, int passes, size_t budgetBytes) {
+    mt19937_64 random(49);
+    vector<Patient> sample;
+    sample.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        sample.push_back(randomPatient(random));
+    }
+
+    DiscardBuffer discard;
+    ostream sink(&discard);
+    auto start = chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const Patient& patient : sample) patient.display(sink);
+    }
+    double renderSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    PatientViewCache views(budgetBytes);
+    start = chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const Patient& patient : sample) views.display(patient, sink);
+    }
+    double cachedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double shown = static_cast<double>(count) * passes;
+    cout << "Rendered every time: " << renderSeconds << " s (" << shown / renderSeconds << " views/s)" << endl;
+    cout << "Through the cache: " << cachedSeconds << " s (" << shown / cachedSeconds << " views/s)" << endl;
+    cout << "Hit rate: " << 100.0 * views.hits / max<uint64_t>(views.hits + views.misses, 1) << "% with "
+         << views.entries() << " views in " << views.bytes() / 1024 << " KiB, " << views.evictions << " evictions" << endl;
+}
+
+void managePatientViews() {
+    cout << "\n--- Patient View Cache ---" << endl;
+    cout << "1. Cache Statistics" << endl;
+    cout << "2. Set Cache Budget" << endl;
+    cout << "3. Listing Benchmark" << endl;
+    cout << "Enter your choice: ";
+
+    try {
+        int option = getValidIntegerInput("");
         switch (option) {
-            case 1:
-                receptionist.manageAppointments(appointments, patients, doctors);
+            case 1: {
+                uint64_t lookups = patientViews.hits + patientViews.misses;
+                cout << "Cached views: " << patientViews.entries() << endl;
+                cout << "Cache size: " << patientViews.bytes() << " of " << patientViews.capacity() << " bytes" << endl;
+                cout << "Hits: " << patientViews.hits << ", misses: " << patientViews.misses << endl;
+                if (lookups > 0) cout << "Hit rate: " << 100.0 * patientViews.hits / lookups << "%" << endl;
+                cout << "Evictions: " << patientViews.evictions << endl;
                 break;
+            }
             case 2: {
-                string patientName;
-                cout << "Enter patient name to view details: ";
-                cin >> patientName;
-                auto it = find_if(patients.begin(), patients.end(),
-                                     [&](const unique_ptr<Patient>& p){ return p->matchesName(patientName); });
-                if (it != patients.end()) {
-                    displayDetails(**it);
-                } else {
-                    cout << "Patient not found!" << endl;
+                int kilobytes = getValidIntegerInput("Cache budget in KiB: ");
+                if (kilobytes < 0) {
+                    throw InvalidInputException("Cache budget cannot be negative.");
                 }
+                patientViews.resize(static_cast<size_t>(kilobytes) * 1024);
+                cout << "Cache budget set; " << patientViews.entries() << " views kept." << endl;
                 break;
             }
-            case 3:
-                receptionist.displayEarnings();
+            case 3: {
+                int count = getValidIntegerInput("Number of patients: ");
+                int passes = getValidIntegerInput("Number of listings: ");
+                int kilobytes = getValidIntegerInput("Cache budget in KiB: ");
+                if (count < 1 || passes < 1 || kilobytes < 0) {
+                    throw InvalidInputException("Counts must be positive.");
+                }
+                benchmarkPatientViews(count, passes, static_cast<size_t>(kilobytes) * 1024);
                 break;
+            }
             default:
                 cout << "Invalid choice!" << endl;
         }
@@ -502,180 +6203,495 @@ void handleReceptionist(const vector<unique_ptr<Appointment>>& appointments, con
     }
 }
 
-void handleAdministrator(Inventory& inventory, const vector<unique_ptr<Patient>>& patients) {
-    cout << "Welcome, Administrator!" << endl;
-    string adminName;
-    cout << "Enter Administrator's name: ";
-    cin >> adminName;
-    Administrator administrator(adminName);
+// ABO/Rh blood groups. Bit 0 is the RhD antigen and bits 1 and 2 the B and A
+// antigens, so a donor suits a recipient when it carries no antigen the
+// recipient lacks.
+enum class BloodType : uint8_t { ONeg, OPos, BNeg, BPos, ANeg, APos, ABNeg, ABPos };
 
-    int choice;
-    cout << "What would you like to do?" << endl;
-    cout << "1. Manage Inventory" << endl;
-    cout << "2. View Patient Details" << endl;
-    cout << "3. View Earnings" << endl;
-    cout << "Enter your choice (1-3): ";
-    try {
-        choice = getValidIntegerInput("");
-        switch (choice) {
-            case 1:
-                administrator.manageInventorySystem(inventory);
-                break;
-            case 2:
-                 administrator.displayPatientDetails(patients);
-                 break;
-            case 3:
-                administrator.displayEarnings();
-                break;
-            default:
-                cout << "Invalid choice!" << endl;
+constexpr size_t bloodTypeCount = 8;
+constexpr const char* bloodTypeNames[bloodTypeCount] = { "O-", "O+", "B-", "B+", "A-", "A+", "AB-", "AB+" };
+constexpr uint32_t bloodShelfLifeMinutes = 42 * 24 * 60;   // red cells keep 42 days
+
+struct CompatibilityMatrix {
+    uint8_t donors[bloodTypeCount];   // bit d set when donor type d suits the recipient
+};
+
+constexpr CompatibilityMatrix buildCompatibilityMatrix() {
+    CompatibilityMatrix matrix = {};
+    for (size_t recipient = 0; recipient < bloodTypeCount; ++recipient) {
+        for (size_t donor = 0; donor < bloodTypeCount; ++donor) {
+            if ((donor & ~recipient) == 0) matrix.donors[recipient] |= static_cast<uint8_t>(1u << donor);
         }
-    } catch (const InvalidInputException& e) {
-        cerr << "Error: " << e.what() << endl;
     }
+    return matrix;
 }
 
-void addNewPatient(vector<unique_ptr<Patient>>& patients) {
-    string name, phoneNumber, appointmentDate = "";
-    int previousAdmittances = 0;
-    double paymentDue = 0.0;
-    bool hasAppointment = false;
+constexpr CompatibilityMatrix bloodCompatibility = buildCompatibilityMatrix();
+static_assert(bloodCompatibility.donors[size_t(BloodType::ONeg)] == 0x01, "O- takes only O-");
+static_assert(bloodCompatibility.donors[size_t(BloodType::ABPos)] == 0xFF, "AB+ takes every type");
+static_assert(bloodCompatibility.donors[size_t(BloodType::ANeg)] == 0x11, "A- takes O- and A-");
 
-    cout << "Enter patient name: ";
-    cin >> name;
+Parsed<BloodType> parseBloodType(string_view text) {
+    if (text.empty()) return { BloodType::ONeg, ParseError::Empty };
+    for (size_t type = 0; type < bloodTypeCount; ++type) {
+        if (text == bloodTypeNames[type]) return { static_cast<BloodType>(type), ParseError::None };
+    }
+    return { BloodType::ONeg, ParseError::Invalid };
+}
 
-    try {
-        previousAdmittances = getValidIntegerInput("Enter previous admittances: ");
-        paymentDue = getValidDoubleInput("Enter payment due: ");
-        hasAppointment = getYesNoInput("Does the patient have an appointment?");
-        if (hasAppointment) {
-            cout << "Enter appointment date and time: ";
-            cin >> appointmentDate;
+BloodType readBloodType(const string& prompt) {
+    cout << prompt;
+    Parsed<BloodType> parsed = parseBloodType(readInputToken());
+    if (!parsed.ok()) {
+        discardInputLine();
+        throw InvalidInputException("Invalid blood type. Use O-, O+, A-, A+, B-, B+, AB- or AB+.");
+    }
+    return parsed.value;
+}
+
+// "<type> Blood bags" items are written only by the blood bank
+bool isBloodBagItem(string_view itemName) {
+    const string_view suffix = " Blood bags";
+    if (itemName.size() <= suffix.size() || itemName.substr(itemName.size() - suffix.size()) != suffix) return false;
+    return parseBloodType(itemName.substr(0, itemName.size() - suffix.size())).ok();
+}
+
+// Expiry of units taken over from the inventory, which never recorded one
+constexpr uint32_t unknownExpiry = 0;
+
+struct BloodUnit {
+    uint32_t expiryMinutes;   // unknownExpiry when not recorded
+    uint32_t id;
+    BloodType type;
+
+    bool operator>(const BloodUnit& other) const {
+        return expiryMinutes != other.expiryMinutes ? expiryMinutes > other.expiryMinutes : id > other.id;
+    }
+};
+
+struct CompatibleStock {
+    BloodType type;
+    size_t units;
+    uint32_t oldestExpiry;   // unknownExpiry if any unit of the type has none
+};
+
+// Blood units held per type in heaps ordered by expiry, so the oldest unit of
+// each type is always on top. Every operation holds one lock, which makes an
+// issue of several units all-or-nothing for concurrent requests. Unit counts
+// are mirrored into the inventory's "<type> Blood bags" items, and the bank is
+// the only writer of those items.
+//
+// Bags already in the inventory when the bank takes over have no recorded
+// expiry. They are kept apart as undated units, never discarded as expired,
+// and issued before any dated unit.
+class BloodBank {
+private:
+    typedef priority_queue<BloodUnit, vector<BloodUnit>, greater<BloodUnit>> ExpiryHeap;
+
+    ExpiryHeap stock[bloodTypeCount];
+    vector<uint32_t> undated[bloodTypeCount];   // ids of units with unknown expiry
+    Inventory& inventory;
+    mutable mutex lock;
+    uint32_t nextId;
+    uint64_t issued;
+    uint64_t expired;
+    uint64_t refused;
+
+    static string label(size_t type) {
+        return string(bloodTypeNames[type]) + " Blood bags";
+    }
+
+    void releaseFromInventory(size_t type, int units) {
+        inventory.removeItem(label(type), units);
+    }
+
+    size_t unitsOf(size_t type) const {
+        return undated[type].size() + stock[type].size();
+    }
+
+    uint32_t oldestExpiry(size_t type) const {
+        return undated[type].empty() ? stock[type].top().expiryMinutes : unknownExpiry;
+    }
+
+    // Expired units are always at the top of their heap
+    void discardExpired(size_t type, uint32_t now) {
+        int discarded = 0;
+        while (!stock[type].empty() && stock[type].top().expiryMinutes <= now) {
+            stock[type].pop();
+            ++discarded;
         }
-        cout << "Enter phone number: ";
-        cin >> phoneNumber;
+        if (discarded > 0) {
+            expired += discarded;
+            releaseFromInventory(type, discarded);
+        }
+    }
 
-        patients.push_back(make_unique<Patient>(name, previousAdmittances, paymentDue, hasAppointment, appointmentDate, phoneNumber));
-        cout << "New patient added successfully!" << endl;
-    } catch (const InvalidInputException& e) {
-        cerr << "Error: " << e.what() << endl;
+    uint32_t add(BloodType type, uint32_t expiryMinutes) {
+        uint32_t id = nextId++;
+        stock[size_t(type)].push({ expiryMinutes, id, type });
+        return id;
     }
-}
 
-void addNewAppointment(vector<unique_ptr<Appointment>>& appointments, const vector<unique_ptr<Patient>>& patients, const vector<unique_ptr<Doctor>>& doctors) {
-    string patientName, doctorName, dateTime;
+public:
+    // Takes over the blood bags already in the inventory as undated units
+    BloodBank(Inventory& inv) : inventory(inv), nextId(1), issued(0), expired(0), refused(0) {
+        for (size_t type = 0; type < bloodTypeCount; ++type) {
+            int units = inventory.quantityOf(label(type));
+            for (int i = 0; i < units; ++i) undated[type].push_back(nextId++);
+            reverse(undated[type].begin(), undated[type].end());   // lowest id is issued first
+        }
+    }
 
-    cout << "Enter patient name for the appointment: ";
-    cin >> patientName;
+    BloodBank(const BloodBank&) = delete;
+    BloodBank& operator=(const BloodBank&) = delete;
 
-    auto patientIt = find_if(patients.begin(), patients.end(),
-                                 [&](const unique_ptr<Patient>& p){ return p->getName() == patientName; });
-    if (patientIt == patients.end()) {
-        cout << "Patient not found!" << endl;
-        return;
+    uint32_t receive(BloodType type, uint32_t expiryMinutes) {
+        lock_guard<mutex> guard(lock);
+        uint32_t id = add(type, expiryMinutes);
+        inventory.addItem(label(size_t(type)), 1);
+        return id;
     }
 
-    cout << "Enter doctor's name for the appointment: ";
-    cin >> doctorName;
+    // Units a recipient can take: count and oldest expiry per donor type, one
+    // heap top per type, soonest to expire first
+    vector<CompatibleStock> compatibleFor(BloodType recipient) {
+        lock_guard<mutex> guard(lock);
+        uint32_t now = currentMinutes();
+        vector<CompatibleStock> found;
+        for (size_t type = 0; type < bloodTypeCount; ++type) {
+            if (!(bloodCompatibility.donors[size_t(recipient)] >> type & 1)) continue;
+            discardExpired(type, now);
+            if (unitsOf(type) > 0) {
+                found.push_back({ static_cast<BloodType>(type), unitsOf(type), oldestExpiry(type) });
+            }
+        }
+        sort(found.begin(), found.end(), [](const CompatibleStock& a, const CompatibleStock& b) {
+            return a.oldestExpiry < b.oldestExpiry;
+        });
+        return found;
+    }
 
-    cout << "Enter appointment date and time (e.g.,YYYY-MM-DD HH:MM): ";
-    cin.ignore();
-    getline(cin, dateTime);
+    // Issues count compatible units, undated ones first and then always the
+    // one closest to expiry, or nothing at all when fewer than count are available
+    vector<BloodUnit> issue(BloodType recipient, size_t count) {
+        lock_guard<mutex> guard(lock);
+        uint32_t now = currentMinutes();
+        uint8_t donors = bloodCompatibility.donors[size_t(recipient)];
+        size_t available = 0;
+        for (size_t type = 0; type < bloodTypeCount; ++type) {
+            if (!(donors >> type & 1)) continue;
+            discardExpired(type, now);
+            available += unitsOf(type);
+        }
+        if (count == 0 || available < count) {
+            ++refused;
+            return {};
+        }
 
-    appointments.push_back(make_unique<Appointment>(patientName, dateTime, doctorName));
-    cout << "New appointment scheduled successfully!" << endl;
-}
+        vector<BloodUnit> units;
+        int taken[bloodTypeCount] = {};
+        for (size_t type = 0; type < bloodTypeCount && units.size() < count; ++type) {
+            if (!(donors >> type & 1)) continue;
+            while (!undated[type].empty() && units.size() < count) {
+                units.push_back({ unknownExpiry, undated[type].back(), static_cast<BloodType>(type) });
+                undated[type].pop_back();
+                ++taken[type];
+            }
+        }
+        while (units.size() < count) {
+            size_t oldest = bloodTypeCount;
+            for (size_t type = 0; type < bloodTypeCount; ++type) {
+                if (!(donors >> type & 1) || stock[type].empty()) continue;
+                if (oldest == bloodTypeCount || stock[oldest].top() > stock[type].top()) oldest = type;
+            }
+            units.push_back(stock[oldest].top());
+            stock[oldest].pop();
+            ++taken[oldest];
+        }
+        for (size_t type = 0; type < bloodTypeCount; ++type) {
+            if (taken[type] > 0) releaseFromInventory(type, taken[type]);
+        }
+        issued += units.size();
+        return units;
+    }
 
-void displayAllAppointments(const vector<unique_ptr<Appointment>>& appointments) {
-    cout << "--- All Scheduled Appointments ---" << endl;
-    if (appointments.empty()) {
-        cout << "No appointments scheduled." << endl;
-        return;
+    // (type, units, oldest expiry); the expiry is unknownExpiry when the type
+    // holds undated units and meaningless when units is 0
+    template <typename Visitor>
+    void forEachType(Visitor visit) {
+        lock_guard<mutex> guard(lock);
+        uint32_t now = currentMinutes();
+        for (size_t type = 0; type < bloodTypeCount; ++type) {
+            discardExpired(type, now);
+            visit(static_cast<BloodType>(type), unitsOf(type), unitsOf(type) > 0 ? oldestExpiry(type) : unknownExpiry);
+        }
     }
-    for (const auto& appointment : appointments) {
-        displayDetails(*appointment);
-        cout << "------------------------------" << endl;
+
+    void displayCounters() const {
+        lock_guard<mutex> guard(lock);
+        cout << "Units issued: " << issued << ", expired and discarded: " << expired
+             << ", requests refused: " << refused << endl;
     }
-}
+};
 
-void searchPatientByName(const vector<unique_ptr<Patient>>& patients) {
-    string searchName;
-    cout << "Enter the name of the patient to search: ";
-    cin >> searchName;
+void displayCompatibilityMatrix() {
+    cout << "Recipient  Compatible donors" << endl;
+    for (size_t recipient = 0; recipient < bloodTypeCount; ++recipient) {
+        cout << left << setw(11) << bloodTypeNames[recipient] << right;
+        for (size_t donor = 0; donor < bloodTypeCount; ++donor) {
+            if (bloodCompatibility.donors[recipient] >> donor & 1) cout << bloodTypeNames[donor] << " ";
+        }
+        cout << endl;
+    }
+}
 
-    auto it = find_if(patients.begin(), patients.end(),
-                        [&](const unique_ptr<Patient>& p){ return p->matchesName(searchName); });
+// Threads issue random requests against a scratch bank; afterwards every unit
+// must have been issued at most once and none may be lost
+void stressBloodBank(int threads, int requestsPerThread) {
+    SharedTables* mirror = sharedMirror;
+    sharedMirror = nullptr;
+    Inventory scratch;
+    BloodBank bank(scratch);
+    mt19937 random(50);
+    uint32_t now = currentMinutes();
+    const int received = threads * requestsPerThread;
+    for (int i = 0; i < received; ++i) {
+        bank.receive(static_cast<BloodType>(random() % bloodTypeCount), now + 60 + random() % bloodShelfLifeMinutes);
+    }
+    size_t seeded = 0;
+    bank.forEachType([&](BloodType, size_t units, uint32_t) { seeded += units; });
 
-    if (it != patients.end()) {
-        cout << "Patient found:" << endl;
-        displayDetails(**it);
-    } else {
-        cout << "Patient with name '" << searchName << "' not found." << endl;
+    MutationLog* active = mutationLog;
+    mutationLog = nullptr;
+    vector<vector<uint32_t>> issuedIds(threads);
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            mt19937 local(t);
+            for (int i = 0; i < requestsPerThread; ++i) {
+                vector<BloodUnit> units = bank.issue(static_cast<BloodType>(local() % bloodTypeCount), 1 + local() % 3);
+                for (const BloodUnit& unit : units) issuedIds[t].push_back(unit.id);
+            }
+        });
     }
+    for (thread& worker : workers) worker.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    mutationLog = active;
+    sharedMirror = mirror;
+
+    vector<uint32_t> all;
+    for (const auto& ids : issuedIds) all.insert(all.end(), ids.begin(), ids.end());
+    sort(all.begin(), all.end());
+    bool unique = adjacent_find(all.begin(), all.end()) == all.end();
+    size_t remaining = 0;
+    bank.forEachType([&](BloodType, size_t units, uint32_t) { remaining += units; });
+
+    cout << threads << " threads made " << threads * requestsPerThread << " requests in " << seconds << " s";
+    if (seconds > 0) cout << " (" << threads * requestsPerThread / seconds << " requests/s)";
+    cout << endl;
+    cout << all.size() << " units issued, " << remaining << " left of " << seeded << endl;
+    bank.displayCounters();
+    cout << (unique && all.size() + remaining == seeded ? "Every unit accounted for exactly once." : "ERROR: units were lost or issued twice.")
+         << endl;
 }
 
-void manageInventory(Inventory& inventory) {
-    int choice;
-    cout << "\n--- Inventory Management ---" << endl;
-    cout << "1. Add Item" << endl;
-    cout << "2. Remove Item" << endl;
-    cout << "3. Display Inventory" << endl;
-    cout << "4. Back to Main Menu" << endl;
+void manageBloodBank(unique_ptr<BloodBank>& bank, Inventory& inventory) {
+    if (!bank) bank = make_unique<BloodBank>(inventory);
+
+    cout << "\n--- Blood Bank ---" << endl;
+    cout << "1. Blood Stock by Type" << endl;
+    cout << "2. Receive Unit" << endl;
+    cout << "3. Compatible Units for Recipient" << endl;
+    cout << "4. Issue Units" << endl;
+    cout << "5. Compatibility Matrix" << endl;
+    cout << "6. Concurrent Issue Test" << endl;
     cout << "Enter your choice: ";
 
     try {
-        choice = getValidIntegerInput("");
-        switch (choice) {
+        int option = getValidIntegerInput("");
+        switch (option) {
             case 1: {
-                string itemName;
-                int quantity;
-                cout << "Enter item name to add: ";
-                cin >> itemName;
-                quantity = getValidIntegerInput("Enter quantity to add: ");
-                inventory.addItem(itemName, quantity);
-                cout << itemName << " added to inventory." << endl;
+                bank->forEachType([](BloodType type, size_t units, uint32_t oldest) {
+                    cout << left << setw(5) << bloodTypeNames[size_t(type)] << right << units << " units";
+                    if (units > 0 && oldest == unknownExpiry) cout << ", some with unknown expiry";
+                    else if (units > 0) cout << ", oldest expires " << formatDateTime(oldest) << " UTC";
+                    cout << endl;
+                });
+                bank->displayCounters();
                 break;
             }
             case 2: {
-                string itemName;
-                int quantity;
-                cout << "Enter item name to remove: ";
-                cin >> itemName;
-                quantity = getValidIntegerInput("Enter quantity to remove: ");
-                try {
-                    inventory.removeItem(itemName, quantity);
-                    cout << quantity << " of " << itemName << " removed from inventory." << endl;
-                } catch (const InsufficientInventoryException& e) {
-                    cerr << "Error: " << e.what() << endl;
+                BloodType type = readBloodType("Enter blood type: ");
+                int days = getValidIntegerInput("Days until expiry: ");
+                if (days < 1 || days > 365) {
+                    throw InvalidInputException("Days until expiry must be between 1 and 365.");
                 }
+                uint32_t id = bank->receive(type, currentMinutes() + static_cast<uint32_t>(days) * 24 * 60);
+                cout << "Received " << bloodTypeNames[size_t(type)] << " unit #" << id << "." << endl;
                 break;
             }
-            case 3:
-                inventory.display();
+            case 3: {
+                BloodType recipient = readBloodType("Enter recipient blood type: ");
+                vector<CompatibleStock> found = bank->compatibleFor(recipient);
+                if (found.empty()) {
+                    cout << "No compatible units in stock." << endl;
+                }
+                for (const CompatibleStock& entry : found) {
+                    cout << bloodTypeNames[size_t(entry.type)] << ": " << entry.units << " units, ";
+                    if (entry.oldestExpiry == unknownExpiry) cout << "some with unknown expiry" << endl;
+                    else cout << "oldest expires " << formatDateTime(entry.oldestExpiry) << " UTC" << endl;
+                }
                 break;
-            case 4:
-                cout << "Returning to main menu." << endl;
+            }
+            case 4: {
+                BloodType recipient = readBloodType("Enter recipient blood type: ");
+                int count = getValidIntegerInput("Units required: ");
+                if (count < 1) {
+                    throw InvalidInputException("Units required must be positive.");
+                }
+                vector<BloodUnit> units = bank->issue(recipient, static_cast<size_t>(count));
+                if (units.empty()) {
+                    cout << "Not enough compatible units; nothing was issued." << endl;
+                }
+                for (const BloodUnit& unit : units) {
+                    cout << "Issued " << bloodTypeNames[size_t(unit.type)] << " unit #" << unit.id << ", ";
+                    if (unit.expiryMinutes == unknownExpiry) cout << "expiry unknown" << endl;
+                    else cout << "expires " << formatDateTime(unit.expiryMinutes) << " UTC" << endl;
+                }
+                break;
+            }
+            case 5:
+                displayCompatibilityMatrix();
+                break;
+            case 6: {
+                int threads = getValidIntegerInput("Number of threads: ");
+                int requests = getValidIntegerInput("Requests per thread: ");
+                if (threads < 1 || requests < 1) {
+                    throw InvalidInputException("Counts must be positive.");
+                }
+                stressBloodBank(threads, requests);
                 break;
+            }
             default:
                 cout << "Invalid choice!" << endl;
         }
     } catch (const InvalidInputException& e) {
         cerr << "Error: " << e.what() << endl;
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
     }
 }
 
-int main() {
+// Main menu labels, indexed by choice
+const char* const mainMenuOptions[] = {
+    "Exit",
+    "Patient",
+    "Nurse",
+    "Doctor",
+    "Receptionist",
+    "Administrator",
+    "Add New Patient",
+    "Add New Appointment",
+    "Display All Appointments",
+    "Search Patient by Name",
+    "Manage Inventory",
+    "Doctor's Appointments Today",
+    "Patient Appointment History",
+    "Appointments Between Dates",
+    "Cancel Appointment",
+    "Caller ID Lookup",
+    "Patient Memory Report",
+    "Export Data",
+    "Reschedule Doctor's Appointments",
+    "Update Payment Due",
+    "Inventory As Of",
+    "Patient Record As Of",
+    "Disk Patient Registry",
+    "Lazy Patient Table",
+    "Historical Archive",
+    "Batch Schedule Appointments",
+    "Payroll Run",
+    "Input Parsing Benchmark",
+    "Shared Tables",
+    "Mutation Event Log",
+    "Stockout Forecast",
+    "Patient View Cache",
+    "Blood Bank",
+    "Formulary Lookup Benchmark",
+};
+
+const int mainMenuSize = sizeof(mainMenuOptions) / sizeof(mainMenuOptions[0]);
+
+// Sits between cin and the terminal and logs every input line with the time
+// since the previous one. Lines read as a main menu choice are tagged "op",
+// so a replay can tell where each operation starts.
+class SessionRecorder : public streambuf {
+private:
+    streambuf* source;
+    ofstream log;
+    string line;
+    chrono::steady_clock::time_point last;
+    bool operationNext;
+
+protected:
+    int underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+        line.clear();
+        int c;
+        while ((c = source->sbumpc()) != traits_type::eof()) {
+            line += static_cast<char>(c);
+            if (c == '\n') break;
+        }
+        if (line.empty()) return traits_type::eof();
+
+        auto now = chrono::steady_clock::now();
+        long delay = chrono::duration_cast<chrono::milliseconds>(now - last).count();
+        last = now;
+        size_t length = line.back() == '\n' ? line.size() - 1 : line.size();
+        log << (operationNext ? "op" : "in") << '\t' << delay << '\t';
+        log.write(line.data(), length);
+        log << endl;
+        operationNext = false;
+
+        setg(&line[0], &line[0], &line[0] + line.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+public:
+    SessionRecorder(streambuf* input, const string& path)
+        : source(input), log(path), last(chrono::steady_clock::now()), operationNext(false) {
+        if (!log) throw runtime_error("Cannot open " + path + " for recording.");
+    }
+
+    void markOperation() {
+        operationNext = true;
+    }
+};
+
+SessionRecorder* sessionRecorder = nullptr;
+
+int runHospitalSystem() {
     vector<unique_ptr<Patient>> patients;
-    patients.push_back(make_unique<Patient>("Vanshika", 2, 30000.0, true, "Saturday, 11th May, 7:30 PM", "7838186547"));
-    patients.push_back(make_unique<Patient>("Anant", 1, 10000.0, false, "", "9812343210"));
-    patients.push_back(make_unique<Patient>("Kanishka", 3, 0.0, false, "", "7890343210"));
-    patients.push_back(make_unique<Patient>("Naysha ", 0, 0.0, true, "Friday, 10th May, 3:00 PM", "88880343210"));
+    PhoneIndex phoneIndex;
+    PatientHistory patientHistory;
+    registerPatient(patients, phoneIndex, patientHistory, make_unique<Patient>("Vanshika", 2, 30000.0, true, "2025-05-11 19:30", "7838186547"));
+    registerPatient(patients, phoneIndex, patientHistory, make_unique<Patient>("Anant", 1, 10000.0, false, "", "9812343210"));
+    registerPatient(patients, phoneIndex, patientHistory, make_unique<Patient>("Kanishka", 3, 0.0, false, "", "7890343210"));
+    registerPatient(patients, phoneIndex, patientHistory, make_unique<Patient>("Naysha ", 0, 0.0, true, "2025-05-10 15:00", "8880343210"));
 
-    vector<unique_ptr<Appointment>> appointments;
-    appointments.push_back(make_unique<Appointment>(" Vanshika", "2025-05-11 19:30", "Dr. Smith"));
-    appointments.push_back(make_unique<Appointment>("Kanishka", "2025-05-10 15:00", "Dr. Jones"));
+    AppointmentBook appointments;
+    appointments.add("Vanshika", "2025-05-11 19:30", "Dr. Smith");
+    appointments.add("Kanishka", "2025-05-10 15:00", "Dr. Jones");
 
     Inventory inventory;
+    unique_ptr<PatientStore> registry;
+    unique_ptr<LazyPatientTable> lazyPatients;
+    unique_ptr<SharedTables> sharedTables;
+    string sharedSegmentName;
+    unique_ptr<MutationLog> eventLog;
+    unique_ptr<BloodBank> bloodBank;
     vector<unique_ptr<Doctor>> doctors;
     doctors.push_back(make_unique<Doctor>("Dr. Smith"));
     doctors.push_back(make_unique<Doctor>("Dr. Jones"));
@@ -687,23 +6703,17 @@ int main() {
     vector<unique_ptr<Administrator>> administrators;
     administrators.push_back(make_unique<Administrator>("Admin Dave"));cout << "Welcome to the HospitalManagement System!" << endl;
 
-    int choice;
+    int choice = -1;
     do {
         cout << "\nPlease select your role:" << endl;
-        cout << "1. Patient" << endl;
-        cout << "2. Nurse" << endl;
-        cout << "3. Doctor" << endl;
-        cout << "4. Receptionist" << endl;
-        cout << "5. Administrator" << endl;
-        cout << "6. Add New Patient" << endl;
-        cout << "7. Add New Appointment" << endl;
-        cout << "8. Display All Appointments" << endl;
-        cout << "9. Search Patient by Name" << endl;
-        cout << "10. Manage Inventory" << endl;
+        for (int option = 1; option < mainMenuSize; ++option) {
+            cout << option << ". " << mainMenuOptions[option] << endl;
+        }
         cout << "0. Exit" << endl;
         cout << "Enter your choice: ";
 
         try {
+            if (sessionRecorder) sessionRecorder->markOperation();
             choice = getValidIntegerInput("");
             switch (choice) {
                 case 1:
@@ -716,13 +6726,13 @@ int main() {
                     handleDoctor(patients, inventory);
                     break;
                 case 4:
-                    handleReceptionist(appointments, patients, doctors);
+                    handleReceptionist(appointments, patients, patientHistory, doctors);
                     break;
                 case 5:
                     handleAdministrator(inventory, patients);
                     break;
                 case 6:
-                    addNewPatient(patients);
+                    addNewPatient(patients, phoneIndex, patientHistory);
                     break;
                 case 7:
                     addNewAppointment(appointments, patients, doctors);
@@ -736,6 +6746,75 @@ int main() {
                 case 10:
                     manageInventory(inventory);
                     break;
+                case 11:
+                    displayDoctorAppointmentsToday(appointments);
+                    break;
+                case 12:
+                    displayPatientAppointmentHistory(appointments);
+                    break;
+                case 13:
+                    displayAppointmentsBetween(appointments);
+                    break;
+                case 14:
+                    cancelAppointment(appointments, patients, patientHistory);
+                    break;
+                case 15:
+                    lookupCaller(patients, phoneIndex);
+                    break;
+                case 16:
+                    displayMemoryReport(patients, phoneIndex);
+                    break;
+                case 17:
+                    exportData(patients, appointments, inventory);
+                    break;
+                case 18:
+                    rescheduleDoctorAppointments(appointments, patients, patientHistory);
+                    break;
+                case 19:
+                    updatePaymentDue(patients, patientHistory);
+                    break;
+                case 20:
+                    displayStockAsOf(inventory);
+                    break;
+                case 21:
+                    displayPatientAsOf(patients, patientHistory);
+                    break;
+                case 22:
+                    manageDiskRegistry(registry, patients);
+                    break;
+                case 23:
+                    manageLazyPatients(lazyPatients, patients);
+                    break;
+                case 24:
+                    manageArchive(appointments, patients, phoneIndex, patientHistory);
+                    break;
+                case 25:
+                    batchScheduleAppointments(appointments, patients, doctors);
+                    break;
+                case 26:
+                    runPayroll(doctors, nurses, receptionists, administrators);
+                    break;
+                case 27:
+                    benchmarkInputParsing();
+                    break;
+                case 28:
+                    manageSharedTables(sharedTables, sharedSegmentName, patients, appointments);
+                    break;
+                case 29:
+                    manageMutationLog(eventLog);
+                    break;
+                case 30:
+                    displayStockForecast(inventory);
+                    break;
+                case 31:
+                    managePatientViews();
+                    break;
+                case 32:
+                    manageBloodBank(bloodBank, inventory);
+                    break;
+                case 33:
+                    benchmarkFormularyLookup();
+                    break;
                 case 0:
                     cout << "Exiting the system. Goodbye!" << endl;
                     break;
@@ -744,9 +6823,264 @@ int main() {
             }
         } catch (const InvalidInputException& e) {
             cerr << "Error: " << e.what() << endl;
+            if (cin.eof()) break;
         }
 
     } while (choice != 0);
 
     return 0;
 }
+
+struct ReplayOperation {
+    int choice;
+    long thinkMs;
+    string choiceLine;
+    vector<pair<long, string>> inputs;
+};
+
+vector<ReplayOperation> loadSession(const string& path) {
+    ifstream in(path);
+    if (!in) throw runtime_error("Cannot open " + path + ".");
+
+    vector<ReplayOperation> operations;
+    string line;
+    while (getline(in, line)) {
+        size_t firstTab = line.find('\t');
+        size_t secondTab = line.find('\t', firstTab + 1);
+        if (firstTab == string::npos || secondTab == string::npos) continue;
+        string kind = line.substr(0, firstTab);
+        long delay = stol(line.substr(firstTab + 1, secondTab - firstTab - 1));
+        string text = line.substr(secondTab + 1);
+
+        if (kind == "op") {
+            int choice = -1;
+            from_chars(text.data(), text.data() + text.size(), choice);
+            operations.push_back({ choice, delay, text, {} });
+        } else if (!operations.empty()) {
+            operations.back().inputs.emplace_back(delay, text);
+        }
+    }
+    return operations;
+}
+
+struct ReplaySample {
+    int choice;
+    double milliseconds;
+};
+
+// Drives one HMS child through the recorded operations. An operation's
+// latency runs from sending its menu choice until the main menu comes back,
+// minus the (scaled) think time spent between its inputs.
+class ReplaySession {
+private:
+    pid_t child;
+    int toChild;
+    int fromChild;
+    string pending;
+    bool finished;
+
+    static constexpr const char* menuMarker = "Please select your role:";
+
+    // Reads child output until the next main menu (or end of output)
+    void awaitMenu() {
+        char buffer[1 << 14];
+        while (true) {
+            size_t found = pending.find(menuMarker);
+            if (found != string::npos) {
+                pending.erase(0, found + strlen(menuMarker));
+                return;
+            }
+            if (pending.size() > strlen(menuMarker)) pending.erase(0, pending.size() - strlen(menuMarker));
+            ssize_t count = read(fromChild, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) {
+                finished = true;
+                return;
+            }
+            pending.append(buffer, count);
+        }
+    }
+
+    void send(const string& text) {
+        string line = text + "\n";
+        const char* data = line.data();
+        size_t left = line.size();
+        while (left > 0) {
+            ssize_t written = write(toChild, data, left);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                finished = true;
+                return;
+            }
+            data += written;
+            left -= written;
+        }
+    }
+
+public:
+    // Forks a child running the interactive system on a pair of pipes.
+    // Call from a single thread, before any replay threads start.
+    ReplaySession() : finished(false) {
+        int input[2], output[2];
+        if (pipe(input) != 0 || pipe(output) != 0) throw runtime_error("Cannot create replay pipes.");
+
+        child = fork();
+        if (child < 0) throw runtime_error("Cannot fork replay session.");
+        if (child == 0) {
+            dup2(input[0], STDIN_FILENO);
+            dup2(output[1], STDOUT_FILENO);
+            int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDERR_FILENO);
+            close(input[0]); close(input[1]); close(output[0]); close(output[1]); close(devNull);
+            runHospitalSystem();
+            cout.flush();
+            _exit(0);
+        }
+        close(input[0]);
+        close(output[1]);
+        toChild = input[1];
+        fromChild = output[0];
+    }
+
+    ReplaySession(const ReplaySession&) = delete;
+    ReplaySession& operator=(const ReplaySession&) = delete;
+
+    ~ReplaySession() {
+        close(toChild);
+        close(fromChild);
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+    }
+
+    void run(const vector<ReplayOperation>& operations, double speed, vector<ReplaySample>& samples) {
+        awaitMenu();
+        for (const auto& operation : operations) {
+            if (finished) return;
+            this_thread::sleep_for(chrono::duration<double, milli>(operation.thinkMs / speed));
+
+            auto start = chrono::steady_clock::now();
+            chrono::duration<double, milli> thinking(0);
+            send(operation.choiceLine);
+            for (const auto& input : operation.inputs) {
+                chrono::duration<double, milli> pause(input.first / speed);
+                this_thread::sleep_for(pause);
+                thinking += pause;
+                send(input.second);
+            }
+            awaitMenu();
+            chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            samples.push_back({ operation.choice, max(0.0, (elapsed - thinking).count()) });
+        }
+    }
+};
+
+int replaySessions(const string& path, int sessionCount, double speed) {
+    vector<ReplayOperation> operations = loadSession(path);
+    if (operations.empty()) {
+        cerr << "Error: " << path << " holds no recorded operations." << endl;
+        return 1;
+    }
+
+    cout.flush();
+    vector<unique_ptr<ReplaySession>> sessions;
+    for (int i = 0; i < sessionCount; ++i) {
+        sessions.push_back(make_unique<ReplaySession>());
+    }
+
+    vector<vector<ReplaySample>> samples(sessionCount);
+    vector<thread> drivers;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < sessionCount; ++i) {
+        drivers.emplace_back([&, i]() { sessions[i]->run(operations, speed, samples[i]); });
+    }
+    for (auto& driver : drivers) driver.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    sessions.clear();
+
+    map<int, vector<double>> byChoice;
+    size_t total = 0;
+    for (const auto& sessionSamples : samples) {
+        for (const auto& sample : sessionSamples) {
+            byChoice[sample.choice].push_back(sample.milliseconds);
+            ++total;
+        }
+    }
+
+    cout << "Replayed " << sessionCount << " sessions of " << operations.size() << " operations at " << speed << "x" << endl;
+    cout << "Throughput: " << total / seconds << " operations/s over " << seconds << " s" << endl;
+    cout << "Latency (ms) per operation:" << endl;
+    for (auto& entry : byChoice) {
+        vector<double>& latencies = entry.second;
+        sort(latencies.begin(), latencies.end());
+        string label = entry.first >= 0 && entry.first < mainMenuSize ? mainMenuOptions[entry.first] : "Invalid choice";
+        cout << label << ": n=" << latencies.size()
+             << " p50=" << percentile(latencies, 0.50)
+             << " p99=" << percentile(latencies, 0.99)
+             << " p999=" << percentile(latencies, 0.999) << endl;
+    }
+    return 0;
+}
+
+// Checks the parse layer against known inputs; run with --self-test
+int runSelfTest() {
+    int failures = 0;
+    auto check = [&](bool passed, const string& what) {
+        if (!passed) {
+            cerr << "FAIL: " << what << endl;
+            ++failures;
+        }
+    };
+
+    check(parseNumber<int>("42").ok() && parseNumber<int>("42").value == 42, "int 42");
+    check(parseNumber<int>("+7").value == 7, "int +7");
+    check(parseNumber<int>("").error == ParseError::Empty, "empty int");
+    check(parseNumber<int>("12abc").error == ParseError::Trailing, "int with trailing text");
+    check(parseNumber<int>("99999999999").error == ParseError::OutOfRange, "int out of range");
+    check(parseNumber<double>("2.5").ok() && parseNumber<double>("2.5").value == 2.5, "double 2.5");
+    check(parseNumber<double>("-0.25").ok(), "double -0.25");
+    check(parseNumber<double>("1e400").error == ParseError::OutOfRange, "double out of range");
+    for (const char* nonFinite : { "nan", "NaN", "-nan", "inf", "+inf", "-inf", "infinity", "INFINITY" }) {
+        check(parseNumber<double>(nonFinite).error == ParseError::Invalid, string("double ") + nonFinite + " rejected");
+    }
+    AdmissionRow row;
+    check(parseAdmissionRow("Ravi,1,nan,n,", row) == ParseError::Invalid, "admission row with nan dues");
+    check(parseAdmissionRow("Ravi,1,20.5,n,", row) == ParseError::None && row.paymentDue == 20.5, "admission row");
+    check(parseYesNo("y").value && !parseYesNo("n").value && parseYesNo("yes").error == ParseError::Invalid, "yes/no");
+    check(parseDateTime("2025-02-29 10:00").error == ParseError::OutOfRange, "2025-02-29 rejected");
+    check(parseDateTime("2024-02-29 10:00").ok(), "2024-02-29 accepted");
+
+    cout << (failures == 0 ? "All self-tests passed." : to_string(failures) + " self-tests failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// HMS                                    interactive desk session
+// HMS --record <file>                    same, logging inputs and their timing
+// HMS --replay <file> [sessions] [speed] replay a recording concurrently
+int main(int argc, char* argv[]) {
+    try {
+        if (argc >= 2 && string(argv[1]) == "--self-test") {
+            return runSelfTest();
+        }
+        if (argc >= 3 && string(argv[1]) == "--record") {
+            SessionRecorder recorder(cin.rdbuf(), argv[2]);
+            streambuf* terminal = cin.rdbuf(&recorder);
+            sessionRecorder = &recorder;
+            int status = runHospitalSystem();
+            sessionRecorder = nullptr;
+            cin.rdbuf(terminal);
+            return status;
+        }
+        if (argc >= 3 && string(argv[1]) == "--replay") {
+            int sessionCount = argc >= 4 ? stoi(argv[3]) : 1;
+            double speed = argc >= 5 ? stod(argv[4]) : 1.0;
+            if (sessionCount < 1 || speed <= 0) {
+                throw InvalidInputException("Sessions and speed must be positive.");
+            }
+            return replaySessions(argv[2], sessionCount, speed);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return runHospitalSystem();
+}
@@ -2,6 +2,13 @@
 
 #include <vector>
 #include <string>
+#include <fstream>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
 
 #include <stdexcept>
 using namespace std;
@@ -46,6 +53,151 @@ bool isValidPhoneNumber(const string& phone) {
     return true;
 }
 
+// Duplicate key for a patient: the name lower-cased, trimmed, with runs of
+// whitespace collapsed, so "Naysha " and "naysha" are the same patient.
+string normalizedPatientKey(const string& name) {
+
+    string key;
+    key.reserve(name.size());
+    bool pendingSpace = false;
+
+    for (char c : name) {
+
+        if (isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace) key += ' ';
+        pendingSpace = false;
+        key += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+uint64_t hashKey(const string& key) {
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+class BloomFilter {
+
+    vector<uint64_t> bits;
+    uint64_t bitCount;
+    int hashCount;
+
+public:
+
+    BloomFilter(size_t expected, double falsePositiveRate) {
+
+        double m = ceil(-static_cast<double>(max<size_t>(expected, 1)) * log(falsePositiveRate) / (log(2.0) * log(2.0)));
+        bitCount = max<uint64_t>(64, static_cast<uint64_t>(m));
+        bits.assign((bitCount + 63) / 64, 0);
+        hashCount = max(1, static_cast<int>(round(m / max<size_t>(expected, 1) * log(2.0))));
+    }
+
+    // Double hashing: probe i is h1 + i * h2
+    void add(uint64_t hash) {
+
+        uint64_t h2 = (hash >> 32) | 1;
+        for (int i = 0; i < hashCount; ++i) {
+            uint64_t bit = (hash + i * h2) % bitCount;
+            bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    bool mightContain(uint64_t hash) const {
+
+        uint64_t h2 = (hash >> 32) | 1;
+        for (int i = 0; i < hashCount; ++i) {
+            uint64_t bit = (hash + i * h2) % bitCount;
+            if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    size_t memoryBytes() const {
+        return bits.size() * sizeof(uint64_t);
+    }
+
+    int hashFunctions() const {
+        return hashCount;
+    }
+};
+
+// Bloom filter in front of an exact set of normalized keys. Most new
+// admissions are rejected by the filter alone, without probing the set.
+class AdmissionDedup {
+
+    static constexpr double targetFalsePositiveRate = 0.01;
+
+    BloomFilter bloom;
+    unordered_set<string> keys;
+    size_t capacity;
+    size_t lookups = 0, filterPasses = 0, falsePositives = 0;
+
+    void rebuild(size_t newCapacity) {
+
+        capacity = newCapacity;
+        bloom = BloomFilter(capacity, targetFalsePositiveRate);
+        for (const string& key : keys) bloom.add(hashKey(key));
+    }
+
+public:
+
+    AdmissionDedup(size_t expected = 1024) : bloom(expected, targetFalsePositiveRate), capacity(expected) {}
+
+    void reserve(size_t expected) {
+
+        keys.reserve(expected);
+        if (expected > capacity) rebuild(expected);
+    }
+
+    // Records the patient and returns true unless the key was already present
+    bool insertIfNew(const string& name) {
+
+        string key = normalizedPatientKey(name);
+        uint64_t hash = hashKey(key);
+        ++lookups;
+
+        if (bloom.mightContain(hash)) {
+            ++filterPasses;
+            if (keys.count(key)) return false;
+            ++falsePositives;
+        }
+
+        if (keys.size() + 1 > capacity) rebuild(capacity * 2);
+        keys.insert(move(key));
+        bloom.add(hash);
+        return true;
+    }
+
+    void displayReport() const {
+
+        size_t setBytes = keys.bucket_count() * sizeof(void*);
+        for (const string& key : keys) {
+            setBytes += sizeof(string) + 2 * sizeof(void*) + (key.capacity() > 15 ? key.capacity() + 1 : 0);
+        }
+        size_t newKeys = lookups - (filterPasses - falsePositives);
+
+        cout << "Duplicate Filter Report\n"
+             << "Patients tracked: " << keys.size() << "\n"
+             << "Lookups: " << lookups << "\n"
+             << "Duplicates rejected: " << filterPasses - falsePositives << "\n"
+             << "Bloom false positives: " << falsePositives;
+        if (newKeys > 0) cout << " (" << 100.0 * falsePositives / newKeys << "% of new patients, target " << 100 * targetFalsePositiveRate << "%)";
+        cout << "\nBloom filter: " << bloom.memoryBytes() << " bytes, " << bloom.hashFunctions() << " hash functions\n"
+             << "Exact key set: ~" << setBytes << " bytes\n";
+    }
+};
+
 
 
 class Person {
@@ -94,6 +246,10 @@ public:
         return name == searchName;
     }
 
+    const string& getName() const {
+        return name;
+    }
+
     void displayDues() const {
         cout << "Payment Due: " << paymentDue << endl;
     }
@@ -246,7 +402,7 @@ public:
     }
 };
 
-void addNewPatient(vector<Patient>& patients) {
+void addNewPatient(vector<Patient>& patients, AdmissionDedup& dedup) {
 
     string name ;
     string phone ;
@@ -293,17 +449,79 @@ void addNewPatient(vector<Patient>& patients) {
     
 
 
-    for (const auto& p : patients) {
-        if (p.matchesName(name)) {
-            cout << "Patient already exists.\n";
-            return;
-        }
+    if (!dedup.insertIfNew(name)) {
+        cout << "Patient already exists.\n";
+        return;
     }
 
     patients.emplace_back(name, admit, due, hasAppt, date, phone);
     cout << "Patient added.\n";
 }
 
+// Admission files hold one "name,admittances,payment,date,phone" row per
+// line; date is empty for patients without an appointment.
+void bulkAdmitPatients(vector<Patient>& patients, AdmissionDedup& dedup) {
+
+    string path;
+    cout << "Admission file: ";
+    cin >> path;
+
+    ifstream in(path);
+    if (!in) {
+        cout << "Error: Cannot open " << path << ".\n";
+        return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    size_t rows = count(istreambuf_iterator<char>(in), istreambuf_iterator<char>(), '\n');
+    in.clear();
+    in.seekg(0);
+    dedup.reserve(patients.size() + rows);
+    patients.reserve(patients.size() + rows);
+
+    size_t added = 0, duplicates = 0, invalid = 0;
+    string row;
+    while (getline(in, row)) {
+
+        // Files saved on Windows end each row with "\r\n"
+        if (!row.empty() && row.back() == '\r') row.pop_back();
+
+        string fields[5];
+        size_t from = 0;
+        int count = 0;
+        for (; count < 5; ++count) {
+            size_t comma = row.find(',', from);
+            fields[count] = row.substr(from, comma == string::npos ? string::npos : comma - from);
+            if (comma == string::npos) break;
+            from = comma + 1;
+        }
+
+        try {
+            if (count != 4 || !isValidName(fields[0]) || !isValidPhoneNumber(fields[4])
+                || (!fields[3].empty() && !isValidDate(fields[3]))) {
+                ++invalid;
+                continue;
+            }
+            int admit = stoi(fields[1]);
+            double due = stod(fields[2]);
+
+            if (!dedup.insertIfNew(fields[0])) {
+                ++duplicates;
+                continue;
+            }
+            patients.emplace_back(fields[0], admit, due, !fields[3].empty(), fields[3], fields[4]);
+            ++added;
+        } catch (const exception&) {
+            ++invalid;
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Admitted " << added << " patients, rejected " << duplicates << " duplicates and " << invalid
+         << " invalid rows in " << seconds << " s\n";
+    dedup.displayReport();
+}
+
 template <typename StaffType>
 
 void handleStaff(StaffType& staff, vector<Patient>& patients) {
@@ -338,12 +556,13 @@ void handleStaff(StaffType& staff, vector<Patient>& patients) {
 int main() {
 
     vector<Patient> patients;
+    AdmissionDedup dedup;
     int choice;
 
     while (true) {
 
         cout << "\nHospital Management System\n"
-             << "1. Patient\n2. Nurse\n3. Doctor\n4. Add New Patient\n5. Exit\n"
+             << "1. Patient\n2. Nurse\n3. Doctor\n4. Add New Patient\n5. Exit\n6. Bulk Admit from File\n7. Duplicate Filter Report\n"
              << "Enter choice: ";
         cin >> choice;
 
@@ -383,7 +602,7 @@ int main() {
             
             case 4:
 
-                addNewPatient(patients);
+                addNewPatient(patients, dedup);
                 break;
 
             case 5:
@@ -391,6 +610,16 @@ int main() {
                 cout << "Exiting...\n";
                 return 0;
 
+            case 6:
+
+                bulkAdmitPatients(patients, dedup);
+                break;
+
+            case 7:
+
+                dedup.displayReport();
+                break;
+
             default:
 
                 cout << "Invalid selection.\n";
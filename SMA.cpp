@@ -2,17 +2,248 @@
 #include <vector>
 #include <iomanip>
 #include <algorithm>
+#include <fstream>
+#include <string>
+#include <charconv>
+#include <queue>
+#include <future>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <thread>
+#include <cctype>
+#include <limits>
+#include <cstring>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
 using namespace std;
+using namespace __gnu_pbds;
 
 struct Student {
 
     int roll;
     string name;
     float marks;
+    int classNo;   // 1-12, 0 if unassigned
+    char section;  // 'A'-'Z', '-' if unassigned
 };
 
+const int maxClass = 12;
+const int sectionCount = 27;
+
+bool isValidClass(int classNo) {
+    return classNo >= 0 && classNo <= maxClass;
+}
+
+// '-' maps to 0 and 'A'-'Z' to 1-26; anything else is -1
+int sectionIndex(char section) {
+    if (section == '-') return 0;
+    if (isalpha(static_cast<unsigned char>(section))) return toupper(static_cast<unsigned char>(section)) - 'A' + 1;
+    return -1;
+}
+
+char sectionName(int index) {
+    return index == 0 ? '-' : static_cast<char>('A' + index - 1);
+}
+
 vector<Student> students;
 
+// Ranking order: higher marks first, ties broken by lower roll number
+bool ranksBefore(const Student& a, const Student& b) {
+    if (a.marks != b.marks) return a.marks > b.marks;
+    return a.roll < b.roll;
+}
+
+struct RankKey {
+
+    float marks;
+    int roll;
+};
+
+// Same order as ranksBefore()
+struct RankOrder {
+
+    bool operator()(const RankKey& a, const RankKey& b) const {
+        if (a.marks != b.marks) return a.marks > b.marks;
+        return a.roll < b.roll;
+    }
+};
+
+// Order-statistics tree over (marks, roll): every query is O(log n) and the
+// ranking is kept current as students are added, so it never needs a sort.
+// Each entry keeps the whole record, so ranked rows still show class and section.
+class Leaderboard {
+
+    tree<RankKey, Student, RankOrder, rb_tree_tag, tree_order_statistics_node_update> ranking;
+
+public:
+
+    void insert(const Student& s) {
+        ranking.insert({ RankKey{ s.marks, s.roll }, s });
+    }
+
+    void erase(const Student& s) {
+        ranking.erase(RankKey{ s.marks, s.roll });
+    }
+
+    size_t size() const {
+        return ranking.size();
+    }
+
+    // 1-based rank of a ranked student
+    size_t rankOf(const Student& s) const {
+        return ranking.order_of_key(RankKey{ s.marks, s.roll }) + 1;
+    }
+
+    // Visits ranks first..last (1-based, inclusive) in ranking order
+    template <typename Visitor>
+    void forRanks(size_t first, size_t last, Visitor visit) const {
+        if (first < 1) first = 1;
+        if (last > ranking.size()) last = ranking.size();
+        if (first > last) return;
+        auto it = ranking.find_by_order(first - 1);
+        for (size_t rank = first; rank <= last; ++rank, ++it) {
+            visit(rank, it->second);
+        }
+    }
+
+    // Visits students with low <= marks <= high in ranking order
+    template <typename Visitor>
+    void forMarksBetween(float low, float high, Visitor visit) const {
+        auto it = ranking.lower_bound(RankKey{ high, numeric_limits<int>::min() });
+        if (it == ranking.end()) return;
+        size_t rank = ranking.order_of_key(it->first) + 1;
+        for (; it != ranking.end() && it->first.marks >= low; ++it, ++rank) {
+            visit(rank, it->second);
+        }
+    }
+};
+
+Leaderboard leaderboard;
+
+// Maps roll numbers to positions in students. Rolls inside a compact range
+// go through a direct-mapped array; outliers that would make the array too
+// sparse go to a hash table instead.
+class RollIndex {
+
+    static const int absent = -1;
+
+    int base = 0;
+    vector<int> dense;
+    unordered_map<int, int> sparse;
+    size_t count = 0;
+
+    bool inDense(int roll) const {
+        return roll >= base && static_cast<long long>(roll) - base < static_cast<long long>(dense.size());
+    }
+
+    // Widens the array to cover roll if it stays at least a quarter full
+    bool growDense(int roll) {
+        long long low = dense.empty() ? roll : min<long long>(base, roll);
+        long long high = dense.empty() ? roll : max<long long>(base + static_cast<long long>(dense.size()) - 1, roll);
+        long long span = high - low + 1;
+        long long limit = 4 * static_cast<long long>(count + 1) + 1024;
+        if (span > limit) return false;
+
+        // Grow geometrically towards roll so ascending rolls do not reallocate on every insert
+        long long target = min(limit, max(span, 2 * static_cast<long long>(dense.size())));
+        if (!dense.empty() && roll < base) low = max<long long>(high - target + 1, numeric_limits<int>::min());
+        else high = min<long long>(low + target - 1, numeric_limits<int>::max());
+        span = high - low + 1;
+
+        vector<int> widened(span, absent);
+        for (size_t i = 0; i < dense.size(); ++i) widened[base - low + i] = dense[i];
+        dense.swap(widened);
+        base = static_cast<int>(low);
+
+        for (auto it = sparse.begin(); it != sparse.end();) {
+            if (inDense(it->first)) {
+                dense[it->first - base] = it->second;
+                it = sparse.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return true;
+    }
+
+public:
+
+    // Position of roll in students, or -1 if there is none
+    int find(int roll) const {
+        if (inDense(roll)) return dense[roll - base];
+        auto it = sparse.find(roll);
+        return it == sparse.end() ? absent : it->second;
+    }
+
+    // Returns false, leaving the index unchanged, if roll is already present
+    bool insert(int roll, int position) {
+        if (find(roll) != absent) return false;
+        if (inDense(roll) || growDense(roll)) dense[roll - base] = position;
+        else sparse[roll] = position;
+        ++count;
+        return true;
+    }
+
+    void move(int roll, int position) {
+        if (inDense(roll)) dense[roll - base] = position;
+        else sparse[roll] = position;
+    }
+
+    void erase(int roll) {
+        if (inDense(roll)) {
+            if (dense[roll - base] == absent) return;
+            dense[roll - base] = absent;
+        } else if (sparse.erase(roll) == 0) {
+            return;
+        }
+        --count;
+    }
+};
+
+RollIndex rollIndex;
+
+// Adds a student unless the roll number is already taken
+bool addStudent(const Student& s) {
+    if (!rollIndex.insert(s.roll, static_cast<int>(students.size()))) return false;
+    students.push_back(s);
+    leaderboard.insert(s);
+    return true;
+}
+
+// Closes the gap in place so a sorted list stays sorted; the students
+// after it each move up one position
+void deleteStudentAt(int position) {
+    leaderboard.erase(students[position]);
+    rollIndex.erase(students[position].roll);
+    students.erase(students.begin() + position);
+    for (size_t i = position; i < students.size(); ++i) rollIndex.move(students[i].roll, static_cast<int>(i));
+}
+
+void readStudentDetails(Student& s) {
+
+    cout << "Name: ";
+    getline(cin, s.name);
+    cout << "Marks: ";
+    cin >> s.marks;
+    cout << "Class (1-" << maxClass << ", 0 if none): ";
+    cin >> s.classNo;
+    cout << "Section (A-Z, - if none): ";
+    cin >> s.section;
+
+    if (!isValidClass(s.classNo)) {
+        cout << "Invalid class, recorded as unassigned.\n";
+        s.classNo = 0;
+    }
+    if (sectionIndex(s.section) < 0) {
+        cout << "Invalid section, recorded as unassigned.\n";
+        s.section = '-';
+    }
+    s.section = sectionName(sectionIndex(s.section));
+}
+
 void inputStudents() {
 
     int n;
@@ -28,15 +259,82 @@ void inputStudents() {
         cin >> s.roll;
         cin.ignore();  
 
-        cout << "Name: ";
-        getline(cin, s.name);
-        cout << "Marks: ";
-        cin >> s.marks;
+        readStudentDetails(s);
 
-        students.push_back(s);
+        if (!addStudent(s)) {
+            cout << "Roll number " << s.roll << " already exists, student not added.\n";
+        }
     }
 }
 
+// Lays out the same columns as the old setw() tables, but formats each row
+// straight into a fixed buffer and hands it to cout in 64 KiB writes.
+class TableWriter {
+
+    static const size_t bufferSize = 1 << 16;
+
+    char buffer[bufferSize];
+    size_t used = 0;
+    bool ranked;
+
+    void put(const char* text, size_t length) {
+        if (used + length > bufferSize) flush();
+        if (length > bufferSize) {
+            cout.write(text, length);
+            return;
+        }
+        memcpy(buffer + used, text, length);
+        used += length;
+    }
+
+    // Left-aligned like setw(width) << left; longer text is not truncated
+    void column(const char* text, size_t length, size_t width) {
+        put(text, length);
+        static const char spaces[] = "                    ";
+        while (length < width) {
+            size_t fill = min(width - length, sizeof(spaces) - 1);
+            put(spaces, fill);
+            length += fill;
+        }
+    }
+
+    template <typename Number>
+    void column(Number value, size_t width) {
+        char digits[32];
+        column(digits, to_chars(digits, digits + sizeof(digits), value).ptr - digits, width);
+    }
+
+public:
+
+    TableWriter(bool withRank) : ranked(withRank) {}
+
+    ~TableWriter() {
+        flush();
+    }
+
+    void header() {
+        if (ranked) column("Rank", 4, 8);
+        column("Roll", 4, 10);
+        column("Name", 4, 20);
+        put("Marks\n", 6);
+    }
+
+    void row(size_t rank, const Student& s) {
+        if (ranked) column(rank, 8);
+        column(s.roll, 10);
+        column(s.name.data(), s.name.size(), 20);
+        char digits[32];
+        // Matches cout's default six significant digits
+        put(digits, to_chars(digits, digits + sizeof(digits), s.marks, chars_format::general, 6).ptr - digits);
+        put("\n", 1);
+    }
+
+    void flush() {
+        cout.write(buffer, used);
+        used = 0;
+    }
+};
+
 void displayAll() {
 
     if (students.empty()) {
@@ -45,13 +343,25 @@ void displayAll() {
     }
 
     cout << " Student Records \n";
-    cout << left << setw(10) << "Roll" << setw(20) << "Name" << "Marks\n";
+    TableWriter table(false);
+    table.header();
+    for (const Student& s : students) table.row(0, s);
+}
+
+void displayPage(size_t page, size_t pageSize) {
 
-    for (int i = 0; i < students.size(); ++i) {
-        cout << left << setw(10) << students[i].roll
-             << setw(20) << students[i].name
-             << students[i].marks << endl;
+    if (page < 1 || pageSize < 1 || (page - 1) * pageSize >= students.size()) {
+        cout << "No records on that page.\n";
+        return;
     }
+    size_t first = (page - 1) * pageSize;
+    size_t last = min(students.size(), first + pageSize);
+    size_t pages = (students.size() + pageSize - 1) / pageSize;
+
+    cout << " Student Records (page " << page << " of " << pages << ")\n";
+    TableWriter table(false);
+    table.header();
+    for (size_t i = first; i < last; ++i) table.row(0, students[i]);
 }
 
 void showStats() {
@@ -67,7 +377,7 @@ void showStats() {
     Student top = students[0];
     Student bottom = students[0];
 
-    for (int i = 0; i < students.size(); ++i) {
+    for (size_t i = 0; i < students.size(); ++i) {
         total += students[i].marks;
         if (students[i].marks > highest) {
             highest = students[i].marks;
@@ -86,6 +396,150 @@ void showStats() {
     cout << "Lowest Scorer: " << bottom.name << " (" << bottom.marks << ")\n";
 }
 
+const char* const gradeBands[] = { "A+ (90-100)", "A (80-89)", "B (70-79)", "C (60-69)", "D (50-59)", "E (40-49)", "F (<40)" };
+const int bandCount = 7;
+
+int gradeBand(float marks) {
+    if (marks >= 90) return 0;
+    if (marks < 40) return bandCount - 1;
+    return 9 - static_cast<int>(marks) / 10;
+}
+
+struct GroupStats {
+
+    size_t count = 0;
+    double total = 0;
+    float highest = -numeric_limits<float>::infinity();
+    float lowest = numeric_limits<float>::infinity();
+    size_t bands[bandCount] = {};
+
+    void add(float marks) {
+        ++count;
+        total += marks;
+        highest = max(highest, marks);
+        lowest = min(lowest, marks);
+        ++bands[gradeBand(marks)];
+    }
+
+    void merge(const GroupStats& other) {
+        count += other.count;
+        total += other.total;
+        highest = max(highest, other.highest);
+        lowest = min(lowest, other.lowest);
+        for (int b = 0; b < bandCount; ++b) bands[b] += other.bands[b];
+    }
+};
+
+// One GroupStats per (class, section), in a dense table
+struct GroupedStats {
+
+    vector<GroupStats> groups;
+
+    GroupedStats() : groups((maxClass + 1) * sectionCount) {}
+
+    GroupStats& at(int classNo, int section) {
+        return groups[classNo * sectionCount + section];
+    }
+
+    const GroupStats& at(int classNo, int section) const {
+        return groups[classNo * sectionCount + section];
+    }
+};
+
+// Splits rows into one contiguous slice per worker. Each worker fills its own
+// GroupedStats, and the tables are merged once every worker has finished.
+GroupedStats aggregateStudents(const vector<Student>& rows, unsigned workers) {
+
+    if (workers == 0) workers = 1;
+    vector<GroupedStats> partials(workers);
+    vector<thread> threads;
+    size_t slice = (rows.size() + workers - 1) / workers;
+
+    for (unsigned w = 0; w < workers; ++w) {
+        threads.emplace_back([&rows, &partials, slice, w]() {
+            GroupedStats local;
+            size_t first = min(rows.size(), w * slice);
+            size_t last = min(rows.size(), first + slice);
+            for (size_t i = first; i < last; ++i) {
+                local.at(rows[i].classNo, sectionIndex(rows[i].section)).add(rows[i].marks);
+            }
+            partials[w] = move(local);
+        });
+    }
+    for (thread& t : threads) t.join();
+
+    GroupedStats result = move(partials[0]);
+    for (unsigned w = 1; w < workers; ++w) {
+        for (size_t g = 0; g < result.groups.size(); ++g) result.groups[g].merge(partials[w].groups[g]);
+    }
+    return result;
+}
+
+void printGroupStats(const string& label, const GroupStats& g) {
+
+    cout << left << setw(12) << label << setw(10) << g.count << setw(10) << fixed << setprecision(2) << g.total / g.count
+         << setw(8) << g.highest << setw(8) << g.lowest;
+    for (int b = 0; b < bandCount; ++b) cout << setw(8) << g.bands[b];
+    cout << defaultfloat << setprecision(6) << "\n";
+}
+
+void showGroupedStats() {
+
+    if (students.empty()) {
+        cout << "No data available.\n";
+        return;
+    }
+
+    unsigned workers = max(1u, thread::hardware_concurrency());
+    GroupedStats stats = aggregateStudents(students, workers);
+
+    cout << left << setw(12) << "Group" << setw(10) << "Count" << setw(10) << "Average" << setw(8) << "High" << setw(8) << "Low";
+    for (int b = 0; b < bandCount; ++b) cout << setw(8) << string(gradeBands[b]).substr(0, string(gradeBands[b]).find(' '));
+    cout << "\n";
+
+    GroupStats overall;
+    for (int c = 0; c <= maxClass; ++c) {
+        GroupStats classTotal;
+        for (int sec = 0; sec < sectionCount; ++sec) classTotal.merge(stats.at(c, sec));
+        if (classTotal.count == 0) continue;
+
+        printGroupStats(c == 0 ? "Unassigned" : "Class " + to_string(c), classTotal);
+        for (int sec = 0; sec < sectionCount; ++sec) {
+            if (stats.at(c, sec).count > 0 && sec > 0) {
+                printGroupStats("  Sec " + string(1, sectionName(sec)), stats.at(c, sec));
+            }
+        }
+        overall.merge(classTotal);
+    }
+    printGroupStats("All", overall);
+
+    cout << "Grade bands:";
+    for (int b = 0; b < bandCount; ++b) cout << " " << gradeBands[b];
+    cout << "\n";
+}
+
+void benchmarkGroupedStats() {
+
+    if (students.empty()) {
+        cout << "No data available.\n";
+        return;
+    }
+
+    unsigned maxWorkers = max(1u, thread::hardware_concurrency());
+    double baseline = 0;
+    cout << left << setw(10) << "Threads" << setw(14) << "Seconds" << setw(16) << "Rows/s" << "Speedup\n";
+    for (unsigned workers = 1;; workers = min(workers * 2, maxWorkers)) {
+        auto start = chrono::steady_clock::now();
+        GroupedStats stats = aggregateStudents(students, workers);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (workers == 1) baseline = seconds;
+
+        cout << left << setw(10) << workers << setw(14) << seconds << setw(16) << static_cast<long long>(students.size() / seconds)
+             << baseline / seconds << "\n";
+        if (workers == maxWorkers) break;
+    }
+}
+
 void sortByMarks() {
 
     if (students.empty()) {
@@ -93,14 +547,445 @@ void sortByMarks() {
         return;
     }
 
-    sort(students.begin(), students.end(), [](Student a, Student b) {
-        return a.marks > b.marks;
-    });
+    sort(students.begin(), students.end(), ranksBefore);
+    // Every student moved, so repoint each roll at its new position
+    for (size_t i = 0; i < students.size(); ++i) rollIndex.move(students[i].roll, static_cast<int>(i));
 
     cout << " Students sorted by marks (high to low):\n";
     displayAll();
 }
 
+template <typename T>
+bool parseField(const char* first, const char* last, T& value) {
+    auto result = from_chars(first, last, value);
+    return result.ec == errc() && result.ptr == last;
+}
+
+// Student files hold one "roll,name,marks,class,section" row per line. Older
+// "roll,name,marks" rows load with no class or section.
+bool parseStudent(const string& line, Student& s) {
+
+    size_t end = line.size();
+    if (end > 0 && line[end - 1] == '\r') --end;
+
+    const char* text = line.data();
+    size_t first = line.find(',');
+    if (first == string::npos || first >= end || !parseField(text, text + first, s.roll)) return false;
+
+    size_t sectionComma = line.rfind(',', end - 1);
+    if (sectionComma == first) return false;
+    size_t classComma = line.rfind(',', sectionComma - 1);
+    size_t marksComma = classComma > first ? line.rfind(',', classComma - 1) : string::npos;
+
+    if (marksComma != string::npos && marksComma > first && end - sectionComma == 2
+        && parseField(text + marksComma + 1, text + classComma, s.marks)
+        && parseField(text + classComma + 1, text + sectionComma, s.classNo)
+        && isValidClass(s.classNo) && sectionIndex(text[end - 1]) >= 0) {
+        s.section = sectionName(sectionIndex(text[end - 1]));
+        s.name.assign(line, first + 1, marksComma - first - 1);
+        return true;
+    }
+
+    if (!parseField(text + sectionComma + 1, text + end, s.marks)) return false;
+    s.classNo = 0;
+    s.section = '-';
+    s.name.assign(line, first + 1, sectionComma - first - 1);
+    return true;
+}
+
+void appendStudent(string& out, const Student& s) {
+
+    char number[32];
+    out.append(number, to_chars(number, number + sizeof(number), s.roll).ptr);
+    out += ',';
+    out += s.name;
+    out += ',';
+    out.append(number, to_chars(number, number + sizeof(number), s.marks).ptr);
+    out += ',';
+    out.append(number, to_chars(number, number + sizeof(number), s.classNo).ptr);
+    out += ',';
+    out += s.section;
+    out += '\n';
+}
+
+const size_t writeChunk = 1 << 20;
+
+void spillRun(vector<Student>& run, const string& path) {
+
+    sort(run.begin(), run.end(), ranksBefore);
+
+    ofstream out(path, ios::binary);
+    string buffer;
+    buffer.reserve(writeChunk + 256);
+    for (const Student& s : run) {
+        appendStudent(buffer, s);
+        if (buffer.size() >= writeChunk) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    if (!out) throw runtime_error("Cannot write sort run " + path);
+}
+
+// Runs merged at once; more runs are merged in several passes, so the
+// number of open files stays bounded however large the input is.
+const size_t mergeFanIn = 64;
+
+// Merges sorted run files into outputPath and returns the rows written.
+// Throws if any run cannot be opened or read back completely.
+size_t mergeRuns(const vector<string>& runPaths, const string& outputPath) {
+
+    vector<unique_ptr<ifstream>> runs;
+    vector<Student> heads(runPaths.size());
+    auto later = [&](size_t a, size_t b) { return ranksBefore(heads[b], heads[a]); };
+    priority_queue<size_t, vector<size_t>, decltype(later)> merge(later);
+    string line;
+
+    auto advance = [&](size_t i) {
+        if (getline(*runs[i], line)) {
+            if (!parseStudent(line, heads[i])) throw runtime_error("Sort run " + runPaths[i] + " is corrupt");
+            merge.push(i);
+        } else if (runs[i]->bad()) {
+            throw runtime_error("Cannot read sort run " + runPaths[i]);
+        }
+    };
+
+    for (size_t i = 0; i < runPaths.size(); ++i) {
+        runs.push_back(make_unique<ifstream>(runPaths[i], ios::binary));
+        if (!runs[i]->is_open()) throw runtime_error("Cannot open sort run " + runPaths[i] + ": " + strerror(errno));
+        advance(i);
+    }
+
+    ofstream out(outputPath, ios::binary);
+    if (!out) throw runtime_error("Cannot open " + outputPath);
+    string buffer;
+    buffer.reserve(writeChunk + 256);
+    size_t written = 0;
+    while (!merge.empty()) {
+        size_t i = merge.top();
+        merge.pop();
+        appendStudent(buffer, heads[i]);
+        ++written;
+        if (buffer.size() >= writeChunk) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+        advance(i);
+    }
+    out.write(buffer.data(), buffer.size());
+    out.close();
+    if (!out) throw runtime_error("Failed writing " + outputPath);
+    return written;
+}
+
+// Out-of-core sortByMarks(): sorts runs of runSize rows in memory, spilling
+// each to a temporary file on a worker thread while the next run is read,
+// then merges the runs into outputPath, at most mergeFanIn at a time. At most
+// two runs are resident.
+void externalSortByMarks(const string& inputPath, const string& outputPath, size_t runSize) {
+
+    ifstream in(inputPath, ios::binary);
+    if (!in) {
+        cout << "Cannot open " << inputPath << ".\n";
+        return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<string> runPaths;
+    vector<Student> reading, sorting;
+    future<void> spill;
+    string line;
+    size_t rows = 0, skipped = 0, passes = 0, written = 0;
+
+    try {
+        while (true) {
+            reading.clear();
+            Student s;
+            while (reading.size() < runSize && getline(in, line)) {
+                if (parseStudent(line, s)) reading.push_back(s);
+                else ++skipped;
+            }
+            if (spill.valid()) spill.get();
+            if (reading.empty()) break;
+
+            rows += reading.size();
+            swap(reading, sorting);
+            runPaths.push_back(outputPath + ".run" + to_string(runPaths.size()));
+            spill = async(launch::async, spillRun, ref(sorting), runPaths.back());
+        }
+        vector<Student>().swap(reading);
+        vector<Student>().swap(sorting);
+    } catch (...) {
+        for (const string& path : runPaths) remove(path.c_str());
+        throw;
+    }
+
+    auto runsDone = chrono::steady_clock::now();
+    size_t runCount = runPaths.size();
+
+    try {
+        // Intermediate passes merge groups of runs into longer runs
+        while (runPaths.size() > mergeFanIn) {
+            vector<string> merged;
+            for (size_t first = 0; first < runPaths.size(); first += mergeFanIn) {
+                vector<string> group(runPaths.begin() + first, runPaths.begin() + min(runPaths.size(), first + mergeFanIn));
+                merged.push_back(outputPath + ".pass" + to_string(passes) + "." + to_string(merged.size()));
+                mergeRuns(group, merged.back());
+                for (const string& path : group) remove(path.c_str());
+            }
+            runPaths.swap(merged);
+            ++passes;
+        }
+        written = mergeRuns(runPaths, outputPath);
+        ++passes;
+    } catch (...) {
+        for (const string& path : runPaths) remove(path.c_str());
+        throw;
+    }
+    for (const string& path : runPaths) remove(path.c_str());
+
+    auto end = chrono::steady_clock::now();
+    double runSeconds = chrono::duration<double>(runsDone - start).count();
+    double mergeSeconds = chrono::duration<double>(end - runsDone).count();
+    double totalSeconds = runSeconds + mergeSeconds;
+
+    if (written != rows) {
+        cout << "Sort failed: read " << rows << " students but wrote " << written << " to " << outputPath << ".\n";
+        return;
+    }
+    cout << "Sorted " << rows << " students into " << outputPath << " using " << runCount << " runs in "
+         << passes << " merge passes\n";
+    if (skipped > 0) cout << "Skipped " << skipped << " malformed rows\n";
+    cout << "Run phase: " << runSeconds << " s, merge phase: " << mergeSeconds << " s";
+    if (totalSeconds > 0) cout << " (" << static_cast<long long>(rows / totalSeconds) << " rows/s)";
+    cout << "\n";
+}
+
+void generateStudents(const string& path, size_t count) {
+
+    ofstream out(path, ios::binary);
+    if (!out) {
+        cout << "Cannot open " << path << ".\n";
+        return;
+    }
+
+    mt19937 rng(42);
+    uniform_int_distribution<int> tenths(0, 1000);
+    uniform_int_distribution<int> classes(1, maxClass);
+    uniform_int_distribution<int> sections(0, 3);
+    string buffer;
+    buffer.reserve(writeChunk + 256);
+    Student s;
+    for (size_t i = 0; i < count; ++i) {
+        s.roll = static_cast<int>(i + 1);
+        s.name = "Student" + to_string(i + 1);
+        s.marks = tenths(rng) / 10.0f;
+        s.classNo = classes(rng);
+        s.section = static_cast<char>('A' + sections(rng));
+        appendStudent(buffer, s);
+        if (buffer.size() >= writeChunk) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    cout << "Wrote " << count << " synthetic students to " << path << "\n";
+}
+
+void sortStudentFile() {
+
+    string inputPath, outputPath;
+    size_t runSize;
+
+    cout << "Input file: ";
+    cin >> inputPath;
+    cout << "Output file: ";
+    cin >> outputPath;
+    cout << "Rows per in-memory run: ";
+    cin >> runSize;
+
+    if (runSize == 0) {
+        cout << "Run size must be positive.\n";
+        return;
+    }
+    try {
+        externalSortByMarks(inputPath, outputPath, runSize);
+    } catch (const runtime_error& e) {
+        cout << "Sort failed: " << e.what() << "\n";
+    }
+}
+
+void generateStudentFile() {
+
+    string path;
+    size_t count;
+
+    cout << "Output file: ";
+    cin >> path;
+    cout << "Number of students: ";
+    cin >> count;
+
+    generateStudents(path, count);
+}
+
+void loadStudentFile() {
+
+    string path;
+    cout << "Input file: ";
+    cin >> path;
+
+    ifstream in(path, ios::binary);
+    if (!in) {
+        cout << "Cannot open " << path << ".\n";
+        return;
+    }
+
+    string line;
+    Student s;
+    size_t loaded = 0, skipped = 0, duplicates = 0;
+    while (getline(in, line)) {
+        if (!parseStudent(line, s)) ++skipped;
+        else if (!addStudent(s)) ++duplicates;
+        else ++loaded;
+    }
+    cout << "Loaded " << loaded << " students";
+    if (skipped > 0) cout << " (skipped " << skipped << " malformed rows)";
+    if (duplicates > 0) cout << " (rejected " << duplicates << " duplicate roll numbers)";
+    cout << "\n";
+}
+
+void showRankOfStudent() {
+
+    int roll;
+    cout << "Roll Number: ";
+    cin >> roll;
+
+    int position = rollIndex.find(roll);
+    if (position < 0) {
+        cout << "No student with roll number " << roll << ".\n";
+        return;
+    }
+    cout << "Roll " << roll << " is ranked " << leaderboard.rankOf(students[position]) << " of " << leaderboard.size() << "\n";
+}
+
+void lookupStudent() {
+
+    int roll;
+    cout << "Roll Number: ";
+    cin >> roll;
+
+    int position = rollIndex.find(roll);
+    if (position < 0) {
+        cout << "No student with roll number " << roll << ".\n";
+        return;
+    }
+    const Student& s = students[position];
+    cout << "Roll: " << s.roll << "\nName: " << s.name << "\nMarks: " << s.marks
+         << "\nClass: " << s.classNo << "\nSection: " << s.section << "\n";
+}
+
+void updateStudent() {
+
+    int roll;
+    cout << "Roll Number: ";
+    cin >> roll;
+    cin.ignore();
+
+    int position = rollIndex.find(roll);
+    if (position < 0) {
+        cout << "No student with roll number " << roll << ".\n";
+        return;
+    }
+
+    Student updated = students[position];
+    readStudentDetails(updated);
+
+    leaderboard.erase(students[position]);
+    students[position] = updated;
+    leaderboard.insert(updated);
+    cout << "Student " << roll << " updated.\n";
+}
+
+void deleteStudent() {
+
+    int roll;
+    cout << "Roll Number: ";
+    cin >> roll;
+
+    int position = rollIndex.find(roll);
+    if (position < 0) {
+        cout << "No student with roll number " << roll << ".\n";
+        return;
+    }
+    deleteStudentAt(position);
+    cout << "Student " << roll << " deleted.\n";
+}
+
+void showStudentsBetweenRanks(size_t first, size_t last) {
+
+    if (first < 1 || first > last || first > leaderboard.size()) {
+        cout << "No students in that rank range.\n";
+        return;
+    }
+    TableWriter table(true);
+    table.header();
+    leaderboard.forRanks(first, last, [&table](size_t rank, const Student& s) { table.row(rank, s); });
+}
+
+void showKthBestStudent() {
+
+    size_t k;
+    cout << "Rank: ";
+    cin >> k;
+    showStudentsBetweenRanks(k, k);
+}
+
+void showRankRange() {
+
+    size_t first, last;
+    cout << "From rank: ";
+    cin >> first;
+    cout << "To rank: ";
+    cin >> last;
+    showStudentsBetweenRanks(first, last);
+}
+
+void showTopStudents() {
+
+    size_t n;
+    cout << "How many top students: ";
+    cin >> n;
+    showStudentsBetweenRanks(1, n);
+}
+
+void showStudentPage() {
+
+    size_t page, pageSize;
+    cout << "Page size: ";
+    cin >> pageSize;
+    cout << "Page number: ";
+    cin >> page;
+    displayPage(page, pageSize);
+}
+
+void showMarksRange() {
+
+    float low, high;
+    cout << "Lowest marks: ";
+    cin >> low;
+    cout << "Highest marks: ";
+    cin >> high;
+
+    if (leaderboard.size() == 0 || low > high) {
+        cout << "No students in that marks range.\n";
+        return;
+    }
+    TableWriter table(true);
+    table.header();
+    leaderboard.forMarksBetween(low, high, [&table](size_t rank, const Student& s) { table.row(rank, s); });
+}
+
 int main() {
 
     int choice;
@@ -112,6 +997,20 @@ do {
     cout << "3. Show Statistics\n";
     cout << "4. Sort by Marks\n";
     cout << "5. Exit\n";
+    cout << "6. Sort Student File (External)\n";
+    cout << "7. Generate Synthetic Student File\n";
+    cout << "8. Load Student File\n";
+    cout << "9. Rank of Student\n";
+    cout << "10. K-th Best Student\n";
+    cout << "11. Students Between Ranks\n";
+    cout << "12. Class and Section Statistics\n";
+    cout << "13. Benchmark Statistics Scaling\n";
+    cout << "14. Look Up Student by Roll\n";
+    cout << "15. Update Student\n";
+    cout << "16. Delete Student\n";
+    cout << "17. Top N Students\n";
+    cout << "18. Page of Students\n";
+    cout << "19. Students in Marks Range\n";
     cout << "Enter your choice: \n";
     cin >> choice;
 
@@ -131,6 +1030,48 @@ do {
         case 5:
             cout << "Exiting program \n";
             break;
+        case 6:
+            sortStudentFile();
+            break;
+        case 7:
+            generateStudentFile();
+            break;
+        case 8:
+            loadStudentFile();
+            break;
+        case 9:
+            showRankOfStudent();
+            break;
+        case 10:
+            showKthBestStudent();
+            break;
+        case 11:
+            showRankRange();
+            break;
+        case 12:
+            showGroupedStats();
+            break;
+        case 13:
+            benchmarkGroupedStats();
+            break;
+        case 14:
+            lookupStudent();
+            break;
+        case 15:
+            updateStudent();
+            break;
+        case 16:
+            deleteStudent();
+            break;
+        case 17:
+            showTopStudents();
+            break;
+        case 18:
+            showStudentPage();
+            break;
+        case 19:
+            showMarksRange();
+            break;
         default:
             cout << "Invalid choice! Please try again.\n";
     }